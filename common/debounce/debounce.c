@@ -0,0 +1,112 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "debounce.h"
+
+#include <errno.h>
+
+static void burst_start(struct debounce_input *input)
+{
+	/* Masked until the level settled, the bounce raises no interrupts */
+	gpio_pin_interrupt_configure_dt(&input->spec, GPIO_INT_DISABLE);
+
+	input->burst_ms = k_uptime_get_32();
+	input->bounces = 0;
+	input->stable_samples = 0;
+	/* The edge that started the burst is not a bounce */
+	input->last_sample = !input->level;
+	k_work_reschedule(&input->work, K_MSEC(CONFIG_DEBOUNCE_SAMPLE_MS));
+}
+
+static void edge_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+	struct debounce_input *input = CONTAINER_OF(cb, struct debounce_input, gpio_cb);
+
+	burst_start(input);
+}
+
+static void level_report(struct debounce_input *input)
+{
+	struct debounce_event evt = {
+		.type = input->level ? DEBOUNCE_PRESSED : DEBOUNCE_RELEASED,
+		.timestamp_ms = input->burst_ms,
+		.bounces = input->bounces,
+	};
+
+	if (input->level) {
+		input->press_ms = input->burst_ms;
+	} else {
+		evt.duration_ms = input->burst_ms - input->press_ms;
+	}
+
+	input->cb(input, &evt);
+}
+
+static void sample_work(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct debounce_input *input = CONTAINER_OF(dwork, struct debounce_input, work);
+	int val = gpio_pin_get_dt(&input->spec);
+
+	if (val < 0) {
+		gpio_pin_interrupt_configure_dt(&input->spec, GPIO_INT_EDGE_BOTH);
+		return;
+	}
+
+	if ((bool)val != input->last_sample) {
+		input->last_sample = val;
+		input->stable_samples = 0;
+		input->bounces++;
+	}
+
+	if (++input->stable_samples < CONFIG_DEBOUNCE_STABLE_SAMPLES) {
+		k_work_schedule(dwork, K_MSEC(CONFIG_DEBOUNCE_SAMPLE_MS));
+		return;
+	}
+
+	if ((bool)val != input->level) {
+		input->level = val;
+		level_report(input);
+	}
+
+	gpio_pin_interrupt_configure_dt(&input->spec, GPIO_INT_EDGE_BOTH);
+
+	/* An edge between the last sample and unmasking raised no interrupt */
+	if (gpio_pin_get_dt(&input->spec) != input->level) {
+		burst_start(input);
+	}
+}
+
+int debounce_input_init(struct debounce_input *input, const struct gpio_dt_spec *spec,
+			debounce_cb_t cb)
+{
+	int ret;
+
+	if (!gpio_is_ready_dt(spec)) {
+		return -ENODEV;
+	}
+
+	input->spec = *spec;
+	input->cb = cb;
+	k_work_init_delayable(&input->work, sample_work);
+
+	ret = gpio_pin_configure_dt(spec, GPIO_INPUT);
+	if (ret) {
+		return ret;
+	}
+
+	ret = gpio_pin_get_dt(spec);
+	if (ret < 0) {
+		return ret;
+	}
+	input->level = ret;
+
+	gpio_init_callback(&input->gpio_cb, edge_isr, BIT(spec->pin));
+	ret = gpio_add_callback(spec->port, &input->gpio_cb);
+	if (ret) {
+		return ret;
+	}
+
+	return gpio_pin_interrupt_configure_dt(spec, GPIO_INT_EDGE_BOTH);
+}
@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/gpio.h>
+
+/*
+ * Debounced GPIO input shared by the samples.
+ *
+ * The first edge of a burst masks the pin interrupt. From then on the
+ * level is sampled every CONFIG_DEBOUNCE_SAMPLE_MS until it has held for
+ * CONFIG_DEBOUNCE_STABLE_SAMPLES samples, and only then a change of the
+ * debounced level is reported and the interrupt unmasked. A bouncing
+ * press costs one interrupt and a few timer wakeups instead of one
+ * callback per edge.
+ */
+
+struct debounce_input;
+
+enum debounce_event_type {
+	DEBOUNCE_PRESSED,
+	DEBOUNCE_RELEASED,
+};
+
+struct debounce_event {
+	enum debounce_event_type type;
+	/* Uptime of the first edge of the burst */
+	uint32_t timestamp_ms;
+	/* Time since the press, only for DEBOUNCE_RELEASED */
+	uint32_t duration_ms;
+	/* Level changes seen while sampling the burst */
+	uint16_t bounces;
+};
+
+/* Called from the system work queue */
+typedef void (*debounce_cb_t)(struct debounce_input *input, const struct debounce_event *evt);
+
+/* Input instance, all fields are private */
+struct debounce_input {
+	struct gpio_dt_spec spec;
+	debounce_cb_t cb;
+	struct gpio_callback gpio_cb;
+	struct k_work_delayable work;
+	uint32_t burst_ms;
+	uint32_t press_ms;
+	uint16_t bounces;
+	uint8_t stable_samples;
+	bool level;
+	bool last_sample;
+};
+
+/* Configure spec as an input and report its debounced edges to cb. The
+ * active level follows the devicetree flags of spec.
+ */
+int debounce_input_init(struct debounce_input *input, const struct gpio_dt_spec *spec,
+			debounce_cb_t cb);
+
+/* Debounced level, true when active */
+static inline bool debounce_input_level(const struct debounce_input *input)
+{
+	return input->level;
+}
+
+#endif /* DEBOUNCE_H_ */
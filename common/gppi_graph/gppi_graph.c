@@ -0,0 +1,292 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "gppi_graph.h"
+
+#include <errno.h>
+#include <string.h>
+
+#if __has_include(<zephyr/logging/log.h>)
+#include <zephyr/logging/log.h>
+#else
+#include <logging/log.h>
+#endif
+LOG_MODULE_REGISTER(gppi_graph, LOG_LEVEL_INF);
+
+#define GROUP_TEP_MAX GPPI_GRAPH_TEP_GROUP_DIS(GPPI_GRAPH_GROUPS_MAX - 1)
+
+static uint32_t tep_resolve(const struct gppi_graph *graph, uint32_t tep)
+{
+	if ((tep == 0) || (tep > GROUP_TEP_MAX)) {
+		return tep;
+	}
+
+	nrfx_gppi_channel_group_t group = graph->groups[(tep - 1) / 2];
+
+	if (tep & 1) {
+		return nrfx_gppi_task_address_get(nrfx_gppi_group_enable_task_get(group));
+	}
+
+	return nrfx_gppi_task_address_get(nrfx_gppi_group_disable_task_get(group));
+}
+
+static uint32_t channel_mask(const struct gppi_graph *graph, uint32_t links)
+{
+	uint32_t mask = 0;
+
+	for (size_t i = 0; i < graph->link_count; i++) {
+		if (links & BIT(i)) {
+			mask |= BIT(graph->channels[i]);
+		}
+	}
+
+	return mask;
+}
+
+/* Links whose channel is currently enabled */
+static uint32_t links_enabled(const struct gppi_graph *graph)
+{
+	uint32_t links = 0;
+
+	for (size_t i = 0; i < graph->link_count; i++) {
+		if (nrfx_gppi_channel_check(graph->channels[i])) {
+			links |= BIT(i);
+		}
+	}
+
+	return links;
+}
+
+static bool tep_valid(const struct gppi_graph_desc *desc, uint32_t tep)
+{
+	return (tep == 0) || (tep > GROUP_TEP_MAX) ||
+	       (((tep - 1) / 2) < desc->group_count);
+}
+
+#if defined(DPPI_PRESENT)
+/* Group tasks are compared before they are resolved, which is the same
+ * as every group of a description resolves to a different task
+ */
+static bool tep_used(const struct gppi_graph_link *link, uint32_t tep)
+{
+	return (link->tep == tep) || (link->fork_tep == tep);
+}
+#endif
+
+static int desc_check(const struct gppi_graph_desc *desc)
+{
+	if ((desc->link_count > GPPI_GRAPH_LINKS_MAX) ||
+	    (desc->group_count > GPPI_GRAPH_GROUPS_MAX)) {
+		return -ENOMEM;
+	}
+
+	for (size_t i = 0; i < desc->link_count; i++) {
+		const struct gppi_graph_link *link = &desc->links[i];
+
+		if (!link->eep || !link->tep || !tep_valid(desc, link->tep) ||
+		    !tep_valid(desc, link->fork_tep)) {
+			return -EINVAL;
+		}
+
+		if ((link->group != GPPI_GRAPH_NO_GROUP) &&
+		    ((link->group < 0) || (link->group >= desc->group_count))) {
+			return -EINVAL;
+		}
+
+#if defined(DPPI_PRESENT)
+		/* An event publishes to one channel only, and a task, group
+		 * tasks included, subscribes to one channel only
+		 */
+		if (link->tep == link->fork_tep) {
+			return -EINVAL;
+		}
+
+		for (size_t j = 0; j < i; j++) {
+			if ((desc->links[j].eep == link->eep) ||
+			    tep_used(&desc->links[j], link->tep) ||
+			    (link->fork_tep && tep_used(&desc->links[j], link->fork_tep))) {
+				return -EINVAL;
+			}
+		}
+#endif
+	}
+
+	return 0;
+}
+
+static void resources_free(struct gppi_graph *graph, size_t channels, size_t groups)
+{
+	while (channels--) {
+		nrfx_gppi_channel_free(graph->channels[channels]);
+	}
+
+	while (groups--) {
+		nrfx_gppi_group_free(graph->groups[groups]);
+	}
+}
+
+static int resources_alloc(struct gppi_graph *graph)
+{
+	nrfx_err_t err;
+	size_t groups;
+	size_t channels;
+
+	for (groups = 0; groups < graph->group_count; groups++) {
+		err = nrfx_gppi_group_alloc(&graph->groups[groups]);
+		if (err != NRFX_SUCCESS) {
+			LOG_ERR("nrfx_gppi_group_alloc error: 0x%08X", err);
+			resources_free(graph, 0, groups);
+			return -EBUSY;
+		}
+	}
+
+	for (channels = 0; channels < graph->link_count; channels++) {
+		err = nrfx_gppi_channel_alloc(&graph->channels[channels]);
+		if (err != NRFX_SUCCESS) {
+			LOG_ERR("nrfx_gppi_channel_alloc error: 0x%08X", err);
+			resources_free(graph, channels, groups);
+			return -EBUSY;
+		}
+	}
+
+	return 0;
+}
+
+int gppi_graph_setup(struct gppi_graph *graph, const struct gppi_graph_desc *desc)
+{
+	uint32_t enable = 0;
+	int err;
+
+	err = desc_check(desc);
+	if (err) {
+		LOG_ERR("Invalid graph description");
+		return err;
+	}
+
+	memset(graph, 0, sizeof(*graph));
+	memcpy(graph->links, desc->links, desc->link_count * sizeof(desc->links[0]));
+	graph->link_count = desc->link_count;
+	graph->group_count = desc->group_count;
+
+	err = resources_alloc(graph);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < graph->link_count; i++) {
+		const struct gppi_graph_link *link = &graph->links[i];
+		uint8_t channel = graph->channels[i];
+
+		nrfx_gppi_channel_endpoints_setup(channel, link->eep,
+						  tep_resolve(graph, link->tep));
+		if (link->fork_tep) {
+			nrfx_gppi_fork_endpoint_setup(channel,
+						      tep_resolve(graph, link->fork_tep));
+		}
+
+		if (link->group != GPPI_GRAPH_NO_GROUP) {
+			nrfx_gppi_channels_include_in_group(BIT(channel),
+							    graph->groups[link->group]);
+		}
+
+		if (!link->start_disabled) {
+			enable |= BIT(channel);
+		}
+	}
+
+	nrfx_gppi_channels_enable(enable);
+	graph->active = true;
+
+	return 0;
+}
+
+void gppi_graph_teardown(struct gppi_graph *graph)
+{
+	if (!graph->active) {
+		return;
+	}
+
+	nrfx_gppi_channels_disable(channel_mask(graph, BIT_MASK(graph->link_count)));
+
+	for (size_t i = 0; i < graph->link_count; i++) {
+		const struct gppi_graph_link *link = &graph->links[i];
+		uint8_t channel = graph->channels[i];
+
+		if (link->fork_tep) {
+			nrfx_gppi_fork_endpoint_clear(channel, tep_resolve(graph, link->fork_tep));
+		}
+		nrfx_gppi_channel_endpoints_clear(channel, link->eep,
+						  tep_resolve(graph, link->tep));
+	}
+
+	for (size_t i = 0; i < graph->group_count; i++) {
+		nrfx_gppi_group_disable(graph->groups[i]);
+		nrfx_gppi_group_clear(graph->groups[i]);
+	}
+
+	resources_free(graph, graph->link_count, graph->group_count);
+	graph->active = false;
+}
+
+int gppi_graph_reconfigure(struct gppi_graph *graph, const struct gppi_graph_desc *desc)
+{
+	struct gppi_graph_link old_links[GPPI_GRAPH_LINKS_MAX];
+	struct gppi_graph_desc old_desc = {
+		.links = old_links,
+		.link_count = graph->link_count,
+		.group_count = graph->group_count,
+	};
+	uint32_t old_enabled;
+	int err;
+
+	err = desc_check(desc);
+	if (err) {
+		return err;
+	}
+
+	memcpy(old_links, graph->links, sizeof(old_links));
+
+	/* On DPPI the new links may reuse events of the old ones, so the old
+	 * graph has to go first.
+	 */
+	unsigned int key = irq_lock();
+
+	/* Links switched at runtime differ from their start_disabled flag */
+	old_enabled = links_enabled(graph);
+	gppi_graph_teardown(graph);
+	err = gppi_graph_setup(graph, desc);
+	if (err) {
+		if (gppi_graph_setup(graph, &old_desc)) {
+			LOG_ERR("Graph lost, the old one could not be restored");
+			err = -EFAULT;
+		} else {
+			gppi_graph_links_disable(graph, BIT_MASK(graph->link_count));
+			gppi_graph_links_enable(graph, old_enabled);
+		}
+	}
+
+	irq_unlock(key);
+
+	return err;
+}
+
+void gppi_graph_links_enable(struct gppi_graph *graph, uint32_t links)
+{
+	nrfx_gppi_channels_enable(channel_mask(graph, links));
+}
+
+void gppi_graph_links_disable(struct gppi_graph *graph, uint32_t links)
+{
+	nrfx_gppi_channels_disable(channel_mask(graph, links));
+}
+
+void gppi_graph_group_enable(struct gppi_graph *graph, size_t group)
+{
+	nrfx_gppi_group_enable(graph->groups[group]);
+}
+
+void gppi_graph_group_disable(struct gppi_graph *graph, size_t group)
+{
+	nrfx_gppi_group_disable(graph->groups[group]);
+}
@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef GPPI_GRAPH_H_
+#define GPPI_GRAPH_H_
+
+/* Shared with samples that still build against the unprefixed headers */
+#if __has_include(<zephyr/kernel.h>)
+#include <zephyr/kernel.h>
+#else
+#include <zephyr.h>
+#endif
+#include <helpers/nrfx_gppi.h>
+
+/*
+ * Declarative (D)PPI wiring.
+ *
+ * A graph is a list of event to task links, each with an optional fork
+ * task and channel group. gppi_graph_setup() allocates every channel and
+ * group or none of them, and enables the links in one write, so the same
+ * description runs on PPI (nRF52) and DPPI (nRF53/nRF91) SoCs.
+ *
+ * A task can also be the enable or disable task of one of the graph's
+ * groups, which lets events switch parts of the graph on and off.
+ *
+ * On DPPI an event publishes to a single channel, so two links may not
+ * share an event; use the fork instead. A task also subscribes to a
+ * single channel, so no two tasks or forks of a graph may be the same.
+ */
+
+#define GPPI_GRAPH_LINKS_MAX 8
+#define GPPI_GRAPH_GROUPS_MAX 2
+
+#define GPPI_GRAPH_NO_GROUP (-1)
+
+/* Group tasks, resolved at setup. Real task addresses are never this low. */
+#define GPPI_GRAPH_TEP_GROUP_EN(_group) (1 + (2 * (_group)))
+#define GPPI_GRAPH_TEP_GROUP_DIS(_group) (2 + (2 * (_group)))
+
+struct gppi_graph_link {
+	uint32_t eep;
+	uint32_t tep;
+	/* Second task for the same event, 0 if unused */
+	uint32_t fork_tep;
+	/* Group index in the graph, or GPPI_GRAPH_NO_GROUP */
+	int8_t group;
+	/* Leave the link off at setup, to be enabled by a group task or
+	 * gppi_graph_links_enable()
+	 */
+	bool start_disabled;
+};
+
+struct gppi_graph_desc {
+	const struct gppi_graph_link *links;
+	size_t link_count;
+	size_t group_count;
+};
+
+/* Graph instance, all fields are private */
+struct gppi_graph {
+	struct gppi_graph_link links[GPPI_GRAPH_LINKS_MAX];
+	size_t link_count;
+	size_t group_count;
+	uint8_t channels[GPPI_GRAPH_LINKS_MAX];
+	nrfx_gppi_channel_group_t groups[GPPI_GRAPH_GROUPS_MAX];
+	bool active;
+};
+
+/* Allocate, wire and enable the graph, nothing is left allocated on error */
+int gppi_graph_setup(struct gppi_graph *graph, const struct gppi_graph_desc *desc);
+
+/* Disable all links and release their channels and groups */
+void gppi_graph_teardown(struct gppi_graph *graph);
+
+/* Replace the graph with a new description. Interrupts are locked while
+ * the links are swapped. If the new graph cannot be set up the old one is
+ * restored with the links that were enabled at the time, and the error of
+ * the new graph is returned. -EFAULT means the old graph could not be
+ * restored either, the graph is then torn down.
+ */
+int gppi_graph_reconfigure(struct gppi_graph *graph, const struct gppi_graph_desc *desc);
+
+/* Enable or disable links, BIT(n) selects link n of the description */
+void gppi_graph_links_enable(struct gppi_graph *graph, uint32_t links);
+void gppi_graph_links_disable(struct gppi_graph *graph, uint32_t links);
+
+/* Enable or disable every link of a group at once */
+void gppi_graph_group_enable(struct gppi_graph *graph, size_t group);
+void gppi_graph_group_disable(struct gppi_graph *graph, size_t group);
+
+#endif /* GPPI_GRAPH_H_ */
@@ -0,0 +1,218 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "uart_autosuspend.h"
+
+#include <errno.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/pm/device.h>
+
+#if defined(CONFIG_UART_AUTOSUSPEND_WAKEUP_EDGE)
+#define WAKEUP_INT GPIO_INT_EDGE_TO_ACTIVE
+#else
+/* Masked again in the handler, so it fires once per suspend */
+#define WAKEUP_INT GPIO_INT_LEVEL_ACTIVE
+#endif
+
+static void idle_restart(struct uart_autosuspend *as)
+{
+	if (CONFIG_UART_AUTOSUSPEND_IDLE_MS > 0) {
+		k_work_reschedule(&as->idle_work, K_MSEC(CONFIG_UART_AUTOSUSPEND_IDLE_MS));
+	}
+}
+
+/* Only called by whoever cleared UART_AUTOSUSPEND_SUSPENDED */
+static int resume_owned(struct uart_autosuspend *as)
+{
+	int err;
+
+	if (as->wakeup.port) {
+		gpio_pin_interrupt_configure_dt(&as->wakeup, GPIO_INT_DISABLE);
+	}
+
+	/* Applies the default pin state, which hands RX back to the UART */
+	err = pm_device_action_run(as->uart, PM_DEVICE_ACTION_RESUME);
+
+	as->stats.suspended_ms += k_uptime_get_32() - as->suspend_ms;
+	idle_restart(as);
+
+	return err;
+}
+
+static int suspend_locked(struct uart_autosuspend *as)
+{
+	int err;
+
+	if (uart_autosuspend_is_suspended(as)) {
+		return -EALREADY;
+	}
+
+	err = pm_device_action_run(as->uart, PM_DEVICE_ACTION_SUSPEND);
+	if (err) {
+		return err;
+	}
+
+	as->suspend_ms = k_uptime_get_32();
+	as->stats.suspends++;
+
+	if (as->wakeup.port) {
+		/* The sleep pin state may disconnect the input buffer */
+		gpio_pin_configure_dt(&as->wakeup, GPIO_INPUT);
+	}
+
+	/* Set before arming, a start bit may already be on the line */
+	atomic_set_bit(&as->flags, UART_AUTOSUSPEND_SUSPENDED);
+
+	if (as->wakeup.port) {
+		gpio_pin_interrupt_configure_dt(&as->wakeup, WAKEUP_INT);
+	}
+
+	return 0;
+}
+
+static void wakeup_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+	struct uart_autosuspend *as = CONTAINER_OF(cb, struct uart_autosuspend, gpio_cb);
+	uint32_t start = k_cycle_get_32();
+	uint32_t latency_us;
+
+	if (!atomic_test_and_clear_bit(&as->flags, UART_AUTOSUSPEND_SUSPENDED)) {
+		/* Resumed from a thread meanwhile */
+		gpio_pin_interrupt_configure_dt(&as->wakeup, GPIO_INT_DISABLE);
+		return;
+	}
+
+	resume_owned(as);
+	/* Only a wakeup from the RX pin is preceded by a preamble */
+	as->in_preamble = true;
+
+	latency_us = k_cyc_to_us_ceil32(k_cycle_get_32() - start);
+	as->stats.wakeups++;
+	as->stats.resume_latency_us = latency_us;
+	as->stats.resume_latency_max_us = MAX(as->stats.resume_latency_max_us, latency_us);
+	if (as->preamble_us && (latency_us > as->preamble_us)) {
+		as->stats.late_wakeups++;
+	}
+}
+
+static void idle_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct uart_autosuspend *as = CONTAINER_OF(dwork, struct uart_autosuspend, idle_work);
+
+	k_mutex_lock(&as->lock, K_FOREVER);
+	suspend_locked(as);
+	k_mutex_unlock(&as->lock);
+}
+
+int uart_autosuspend_init(struct uart_autosuspend *as, const struct device *uart,
+			  const struct gpio_dt_spec *wakeup)
+{
+	struct uart_config cfg;
+	int err;
+
+	if (!device_is_ready(uart)) {
+		return -ENODEV;
+	}
+
+	as->uart = uart;
+	as->init_ms = k_uptime_get_32();
+	k_mutex_init(&as->lock);
+	k_work_init_delayable(&as->idle_work, idle_work_handler);
+
+	/* Without runtime configuration the late wakeup check is skipped */
+	if (!uart_config_get(uart, &cfg) && cfg.baudrate) {
+		/* 10 bits per character with 8N1 */
+		as->preamble_us = (uint64_t)CONFIG_UART_AUTOSUSPEND_PREAMBLE_LEN * 10 *
+				  USEC_PER_SEC / cfg.baudrate;
+	}
+
+	if (wakeup && wakeup->port) {
+		if (!gpio_is_ready_dt(wakeup)) {
+			return -ENODEV;
+		}
+
+		as->wakeup = *wakeup;
+		gpio_init_callback(&as->gpio_cb, wakeup_isr, BIT(wakeup->pin));
+		err = gpio_add_callback(wakeup->port, &as->gpio_cb);
+		if (err) {
+			return err;
+		}
+	}
+
+	idle_restart(as);
+
+	return 0;
+}
+
+int uart_autosuspend_activity(struct uart_autosuspend *as)
+{
+	int err = 0;
+
+	k_mutex_lock(&as->lock, K_FOREVER);
+	if (atomic_test_and_clear_bit(&as->flags, UART_AUTOSUSPEND_SUSPENDED)) {
+		err = resume_owned(as);
+	} else {
+		idle_restart(as);
+	}
+	k_mutex_unlock(&as->lock);
+
+	return err;
+}
+
+int uart_autosuspend_suspend(struct uart_autosuspend *as)
+{
+	int err;
+
+	k_mutex_lock(&as->lock, K_FOREVER);
+	k_work_cancel_delayable(&as->idle_work);
+	err = suspend_locked(as);
+	k_mutex_unlock(&as->lock);
+
+	return err;
+}
+
+int uart_autosuspend_resume(struct uart_autosuspend *as)
+{
+	int err = -EALREADY;
+
+	k_mutex_lock(&as->lock, K_FOREVER);
+	if (atomic_test_and_clear_bit(&as->flags, UART_AUTOSUSPEND_SUSPENDED)) {
+		err = resume_owned(as);
+	}
+	k_mutex_unlock(&as->lock);
+
+	return err;
+}
+
+bool uart_autosuspend_rx_filter(struct uart_autosuspend *as, uint8_t c)
+{
+	idle_restart(as);
+
+	if (as->in_preamble) {
+		if (c == CONFIG_UART_AUTOSUSPEND_PREAMBLE_CHAR) {
+			as->stats.preamble_bytes++;
+			return true;
+		}
+		as->in_preamble = false;
+	}
+
+	return false;
+}
+
+void uart_autosuspend_stats_get(struct uart_autosuspend *as,
+				struct uart_autosuspend_stats *stats)
+{
+	unsigned int key = irq_lock();
+	uint32_t now = k_uptime_get_32();
+	uint32_t elapsed = now - as->init_ms;
+
+	*stats = as->stats;
+	if (uart_autosuspend_is_suspended(as)) {
+		stats->suspended_ms += now - as->suspend_ms;
+	}
+	irq_unlock(key);
+
+	stats->idle_percent = elapsed ? ((uint64_t)stats->suspended_ms * 100) / elapsed : 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef UART_AUTOSUSPEND_H_
+#define UART_AUTOSUSPEND_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/atomic.h>
+
+/*
+ * UART suspend on idle, resume on RX activity.
+ *
+ * After CONFIG_UART_AUTOSUSPEND_IDLE_MS without activity the UART is
+ * suspended with pm_device_action_run() and an interrupt is armed on its
+ * RX pin. The falling edge of the next start bit resumes the UART
+ * straight from that interrupt. The byte that woke it is lost, so the
+ * peer sends CONFIG_UART_AUTOSUSPEND_PREAMBLE_LEN preamble characters
+ * first, and uart_autosuspend_rx_filter() drops them on the receive side.
+ */
+
+struct uart_autosuspend_stats {
+	uint32_t suspends;
+	/* Resumes from the RX pin */
+	uint32_t wakeups;
+	/* Wake interrupt to UART resumed, last wakeup and worst. The
+	 * interrupt latency before the handler runs is not included.
+	 */
+	uint32_t resume_latency_us;
+	uint32_t resume_latency_max_us;
+	/* Wakeups that took longer than the preamble lasts */
+	uint32_t late_wakeups;
+	/* Preamble characters dropped by the RX filter */
+	uint32_t preamble_bytes;
+	uint32_t suspended_ms;
+	/* Share of the time since init spent suspended */
+	uint8_t idle_percent;
+};
+
+/* Instance, all fields are private */
+struct uart_autosuspend {
+	const struct device *uart;
+	struct gpio_dt_spec wakeup;
+	struct gpio_callback gpio_cb;
+	struct k_work_delayable idle_work;
+	/* Serializes suspend and resume outside the wake interrupt */
+	struct k_mutex lock;
+	/* UART_AUTOSUSPEND_SUSPENDED, whoever clears it resumes the UART */
+	atomic_t flags;
+	/* Woken by the RX pin and no data byte received yet */
+	bool in_preamble;
+	uint32_t preamble_us;
+	uint32_t init_ms;
+	uint32_t suspend_ms;
+	struct uart_autosuspend_stats stats;
+};
+
+#define UART_AUTOSUSPEND_SUSPENDED 0
+
+/* Start watching uart for idle time. wakeup is the RX pin as a GPIO,
+ * active low so that the start bit is the active edge. Without it the
+ * UART is only resumed by uart_autosuspend_activity() or
+ * uart_autosuspend_resume().
+ */
+int uart_autosuspend_init(struct uart_autosuspend *as, const struct device *uart,
+			  const struct gpio_dt_spec *wakeup);
+
+/* The application is about to use the UART. It is resumed when
+ * suspended and the idle timer restarts. Not callable from ISRs.
+ */
+int uart_autosuspend_activity(struct uart_autosuspend *as);
+
+/* Suspend or resume right away, for example from a button */
+int uart_autosuspend_suspend(struct uart_autosuspend *as);
+int uart_autosuspend_resume(struct uart_autosuspend *as);
+
+/* Pass each received byte through here, from the UART ISR as well.
+ * Returns true for a preamble byte that is to be dropped. This also
+ * restarts the idle timer.
+ */
+bool uart_autosuspend_rx_filter(struct uart_autosuspend *as, uint8_t c);
+
+void uart_autosuspend_stats_get(struct uart_autosuspend *as,
+				struct uart_autosuspend_stats *stats);
+
+static inline bool uart_autosuspend_is_suspended(const struct uart_autosuspend *as)
+{
+	return atomic_test_bit(&as->flags, UART_AUTOSUSPEND_SUSPENDED);
+}
+
+#endif /* UART_AUTOSUSPEND_H_ */
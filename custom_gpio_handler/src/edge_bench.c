@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "edge_bench.h"
+#include "edge_capture.h"
+
+#include <zephyr/sys/printk.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#define EDGES CONFIG_EDGE_CAPTURE_BENCHMARK_EDGES
+
+/* Delay between two generated edges, slowest first */
+static const uint32_t edge_delays_us[] = { 100, 50, 20, 10, 5, 2, 1, 0 };
+
+static const struct gpio_dt_spec *bench_out;
+static uint32_t last_cycles;
+static K_SEM_DEFINE(edge_seen, 0, 1);
+
+static void bench_cb(const struct edge_event *evt)
+{
+	last_cycles = evt->cycles;
+	k_sem_give(&edge_seen);
+}
+
+static void latency_run(void)
+{
+	uint32_t min = UINT32_MAX;
+	uint32_t max = 0;
+	uint64_t sum = 0;
+	uint32_t count = 0;
+
+	for (size_t i = 0; i < EDGES; i++) {
+		k_sem_reset(&edge_seen);
+
+		uint32_t start = (uint32_t)timing_counter_get();
+
+		gpio_pin_toggle_dt(bench_out);
+
+		if (k_sem_take(&edge_seen, K_MSEC(10))) {
+			continue;
+		}
+
+		uint32_t latency = last_cycles - start;
+
+		min = MIN(min, latency);
+		max = MAX(max, latency);
+		sum += latency;
+		count++;
+	}
+
+	if (!count) {
+		printk("Latency: no edge seen, are the two pins jumpered?\n");
+		return;
+	}
+
+	printk("Latency over %u edges: min %" PRIu64 " avg %" PRIu64 " max %" PRIu64 " ns\n",
+	       count, edge_capture_cycles_to_ns(min),
+	       edge_capture_cycles_to_ns(sum / count),
+	       edge_capture_cycles_to_ns(max));
+}
+
+/* Generate EDGES edges delay_us apart, returns the edge rate in Hz */
+static uint32_t rate_step(uint32_t delay_us, uint32_t *lost, uint32_t *dropped)
+{
+	struct edge_capture_stats before;
+	struct edge_capture_stats after;
+
+	edge_capture_stats_get(&before);
+
+	uint32_t start = (uint32_t)timing_counter_get();
+
+	for (size_t i = 0; i < EDGES; i++) {
+		gpio_pin_toggle_dt(bench_out);
+		k_busy_wait(delay_us);
+	}
+
+	uint64_t elapsed_ns = edge_capture_cycles_to_ns((uint32_t)timing_counter_get() - start);
+
+	/* Let the consumer drain the ring */
+	k_msleep(100);
+
+	edge_capture_stats_get(&after);
+	*dropped = after.dropped - before.dropped;
+	/* Edges merged in hardware before the interrupt could run */
+	*lost = EDGES - (after.captured - before.captured) - *dropped;
+
+	return (uint32_t)(((uint64_t)EDGES * NSEC_PER_SEC) / MAX(elapsed_ns, 1));
+}
+
+static void rate_run(void)
+{
+	uint32_t sustained = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(edge_delays_us); i++) {
+		uint32_t lost;
+		uint32_t dropped;
+		uint32_t rate = rate_step(edge_delays_us[i], &lost, &dropped);
+
+		printk("%u us between edges: %u edges/s, %u lost, %u dropped\n",
+		       edge_delays_us[i], rate, lost, dropped);
+
+		if (lost || dropped) {
+			break;
+		}
+		sustained = rate;
+	}
+
+	struct edge_capture_stats stats;
+
+	edge_capture_stats_get(&stats);
+	printk("Sustained %u edges/s without loss, ring high water %u of %u\n",
+	       sustained, stats.high_water, CONFIG_EDGE_CAPTURE_RING_SIZE);
+}
+
+int edge_bench_run(const struct gpio_dt_spec *in, const struct gpio_dt_spec *out)
+{
+	int ret;
+
+	if (!gpio_is_ready_dt(out)) {
+		return -ENODEV;
+	}
+
+	bench_out = out;
+
+	/* Below the consumer, which has to keep draining the ring while the
+	 * edges are generated
+	 */
+	k_thread_priority_set(k_current_get(), CONFIG_EDGE_CAPTURE_THREAD_PRIORITY + 1);
+
+	ret = gpio_pin_configure_dt(out, GPIO_OUTPUT_INACTIVE);
+	if (ret) {
+		return ret;
+	}
+
+	/* A pin driving its own GPIOTE IN channel never sees its edges, the
+	 * channel takes the pin over as an input
+	 */
+	ret = edge_capture_init(in, 0, bench_cb);
+	if (ret) {
+		return ret;
+	}
+
+	latency_run();
+	rate_run();
+
+	return 0;
+}
@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EDGE_BENCH_H_
+#define EDGE_BENCH_H_
+
+#include <zephyr/drivers/gpio.h>
+
+/*
+ * Loopback benchmark of the edge capture on in. The edges are generated
+ * on out, which has to be jumpered to in. Prints the toggle to timestamp
+ * latency and the edge rates reached before edges are lost.
+ */
+int edge_bench_run(const struct gpio_dt_spec *in, const struct gpio_dt_spec *out);
+
+#endif /* EDGE_BENCH_H_ */
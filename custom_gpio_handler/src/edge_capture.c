@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "edge_capture.h"
+
+#include <zephyr/sys/atomic.h>
+
+#define RING_SIZE CONFIG_EDGE_CAPTURE_RING_SIZE
+
+BUILD_ASSERT(IS_POWER_OF_TWO(RING_SIZE), "The ring index wraps with a mask");
+
+static const struct gpio_dt_spec *edge_pin;
+static struct gpio_callback edge_cb_data;
+static edge_capture_cb_t edge_cb;
+
+/* head is only written by the interrupt, tail only by the thread */
+static struct edge_event ring[RING_SIZE];
+static atomic_t head;
+static atomic_t tail;
+static uint32_t seq;
+static struct edge_capture_stats stats;
+
+static K_SEM_DEFINE(edge_sem, 0, 1);
+
+static void edge_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+	/* Timestamp first, everything else adds to the latency */
+	uint32_t cycles = (uint32_t)timing_counter_get();
+	atomic_val_t h = atomic_get(&head);
+	uint32_t used = h - atomic_get(&tail);
+
+	if (used >= RING_SIZE) {
+		stats.dropped++;
+		seq++;
+		return;
+	}
+
+	ring[h & (RING_SIZE - 1)] = (struct edge_event){
+		.seq = seq++,
+		.cycles = cycles,
+		.level = gpio_pin_get_dt(edge_pin),
+	};
+	atomic_set(&head, h + 1);
+
+	stats.captured++;
+	stats.high_water = MAX(stats.high_water, used + 1);
+
+	/* Binary semaphore, a pending wakeup covers any number of edges */
+	k_sem_give(&edge_sem);
+}
+
+static void edge_thread(void)
+{
+	struct edge_event evt;
+
+	for (;;) {
+		k_sem_take(&edge_sem, K_FOREVER);
+
+		while (true) {
+			atomic_val_t t = atomic_get(&tail);
+
+			if (t == atomic_get(&head)) {
+				break;
+			}
+
+			evt = ring[t & (RING_SIZE - 1)];
+			atomic_set(&tail, t + 1);
+
+			edge_cb(&evt);
+		}
+	}
+}
+
+K_THREAD_DEFINE(edge_thread_id, CONFIG_EDGE_CAPTURE_THREAD_STACK_SIZE, edge_thread,
+		NULL, NULL, NULL, CONFIG_EDGE_CAPTURE_THREAD_PRIORITY, 0, 0);
+
+int edge_capture_init(const struct gpio_dt_spec *pin, gpio_flags_t extra_flags,
+		      edge_capture_cb_t cb)
+{
+	int ret;
+
+	if (!gpio_is_ready_dt(pin)) {
+		return -ENODEV;
+	}
+
+	timing_init();
+	timing_start();
+
+	edge_pin = pin;
+	edge_cb = cb;
+
+	ret = gpio_pin_configure_dt(pin, GPIO_INPUT | extra_flags);
+	if (ret) {
+		return ret;
+	}
+
+	gpio_init_callback(&edge_cb_data, edge_isr, BIT(pin->pin));
+	ret = gpio_add_callback(pin->port, &edge_cb_data);
+	if (ret) {
+		return ret;
+	}
+
+	return gpio_pin_interrupt_configure_dt(pin, GPIO_INT_EDGE_BOTH);
+}
+
+void edge_capture_stats_get(struct edge_capture_stats *out)
+{
+	unsigned int key = irq_lock();
+
+	*out = stats;
+	irq_unlock(key);
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EDGE_CAPTURE_H_
+#define EDGE_CAPTURE_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/timing/timing.h>
+
+/*
+ * GPIO edge timestamping.
+ *
+ * The interrupt only reads the cycle counter and the pin level and files
+ * them into a single producer, single consumer ring, without locks. A
+ * thread takes the edges out of the ring and hands them to the callback,
+ * so the time an edge is seen does not depend on how long it takes to
+ * process. Timestamps come from the timing API, the DWT cycle counter
+ * on Cortex-M.
+ */
+
+struct edge_event {
+	/* Index of the edge, dropped edges still take one */
+	uint32_t seq;
+	/* Cycle counter in the interrupt */
+	uint32_t cycles;
+	/* Logical pin level read in the interrupt */
+	uint8_t level;
+};
+
+struct edge_capture_stats {
+	/* Edges put in the ring */
+	uint32_t captured;
+	/* Edges lost because the ring was full */
+	uint32_t dropped;
+	/* Most edges that were waiting in the ring at once */
+	uint32_t high_water;
+};
+
+/* Called from the consumer thread for every edge, in order */
+typedef void (*edge_capture_cb_t)(const struct edge_event *evt);
+
+/*
+ * Configure pin as an input interrupting on both edges and start
+ * capturing. extra_flags are added to GPIO_INPUT.
+ */
+int edge_capture_init(const struct gpio_dt_spec *pin, gpio_flags_t extra_flags,
+		      edge_capture_cb_t cb);
+
+void edge_capture_stats_get(struct edge_capture_stats *stats);
+
+static inline uint64_t edge_capture_cycles_to_ns(uint32_t cycles)
+{
+	return timing_cycles_to_ns(cycles);
+}
+
+#endif /* EDGE_CAPTURE_H_ */
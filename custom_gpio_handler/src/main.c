@@ -11,17 +11,64 @@
 #include <zephyr/sys/util.h>
 #include <zephyr/sys/printk.h>
 #include <inttypes.h>
+#include <errno.h>
 
-#define SLEEP_TIME_MS	1
+#if defined(CONFIG_EDGE_CAPTURE)
+#include "edge_capture.h"
+#include "edge_bench.h"
+#endif
+#if defined(CONFIG_BUTTON_DEBOUNCE)
+#include <debounce.h>
+#endif
 
 static const struct gpio_dt_spec button = GPIO_DT_SPEC_GET(DT_ALIAS(ch1), gpios);
-static struct gpio_callback button_cb_data;
 
-void button_pressed(const struct device *dev, struct gpio_callback *cb,
-		    uint32_t pins)
+#if defined(CONFIG_EDGE_CAPTURE_BENCHMARK)
+BUILD_ASSERT(DT_NODE_HAS_PROP(DT_PATH(zephyr_user), edge_bench_gpios),
+	     "The benchmark needs an edge-bench-gpios pin jumpered to ch1");
+
+static const struct gpio_dt_spec bench_out =
+	GPIO_DT_SPEC_GET(DT_PATH(zephyr_user), edge_bench_gpios);
+#endif
+
+#if defined(CONFIG_EDGE_CAPTURE)
+static struct edge_event last_edge;
+static bool has_last;
+
+void button_edge(const struct edge_event *evt)
+{
+	if (has_last && (evt->seq != last_edge.seq + 1)) {
+		printk("%" PRIu32 " edges dropped\n", evt->seq - last_edge.seq - 1);
+		has_last = false;
+	}
+
+	if (evt->level) {
+		printk("Button pressed at %" PRIu32 "\n", evt->cycles);
+	} else if (has_last && last_edge.level) {
+		printk("Button released after %" PRIu64 " us\n",
+		       edge_capture_cycles_to_ns(evt->cycles - last_edge.cycles) / 1000);
+	} else {
+		printk("Button released at %" PRIu32 "\n", evt->cycles);
+	}
+
+	last_edge = *evt;
+	has_last = true;
+}
+#endif
+
+#if defined(CONFIG_BUTTON_DEBOUNCE)
+static struct debounce_input button_input;
+
+static void button_debounced(struct debounce_input *input, const struct debounce_event *evt)
 {
-	printk("Button pressed at %" PRIu32 "\n", k_cycle_get_32());
+	if (evt->type == DEBOUNCE_PRESSED) {
+		printk("Button pressed at %" PRIu32 " ms, %u bounces\n",
+		       evt->timestamp_ms, evt->bounces);
+	} else {
+		printk("Button released after %" PRIu32 " ms\n", evt->duration_ms);
+	}
 }
+#endif
 
 int main(void)
 {
@@ -33,25 +80,29 @@ int main(void)
 		return 0;
 	}
 
-	ret = gpio_pin_configure_dt(&button, GPIO_INPUT);
+#if defined(CONFIG_EDGE_CAPTURE_BENCHMARK)
+	ret = edge_bench_run(&button, &bench_out);
 	if (ret != 0) {
-		printk("Error %d: failed to configure %s pin %d\n",
+		printk("Error %d: benchmark failed on %s pin %d\n",
 		       ret, button.port->name, button.pin);
-		return 0;
 	}
+	return 0;
+#endif
 
-	ret = gpio_pin_interrupt_configure_dt(&button,
-					      GPIO_INT_EDGE_TO_ACTIVE);
+#if defined(CONFIG_BUTTON_DEBOUNCE)
+	ret = debounce_input_init(&button_input, &button, button_debounced);
+#elif defined(CONFIG_EDGE_CAPTURE)
+	ret = edge_capture_init(&button, 0, button_edge);
+#else
+	ret = -ENOTSUP;
+#endif
 	if (ret != 0) {
-		printk("Error %d: failed to configure interrupt on %s pin %d\n",
-			ret, button.port->name, button.pin);
+		printk("Error %d: failed to set up capture on %s pin %d\n",
+		       ret, button.port->name, button.pin);
 		return 0;
 	}
 
-	gpio_init_callback(&button_cb_data, button_pressed, BIT(button.pin));
-	gpio_add_callback(button.port, &button_cb_data);
 	printk("Set up button at %s pin %d\n", button.port->name, button.pin);
 
-
 	return 0;
 }
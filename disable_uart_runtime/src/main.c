@@ -6,24 +6,33 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/sys/printk.h>
-#include <zephyr/pm/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <uart_autosuspend.h>
+
+/* Boards without the property only resume when printing */
+static const struct gpio_dt_spec rx_wakeup =
+	GPIO_DT_SPEC_GET_OR(DT_PATH(zephyr_user), uart_wakeup_gpios, {0});
+static struct uart_autosuspend uart_as;
 
 void main(void)
 {
 	const struct device *uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+	struct uart_autosuspend_stats stats;
+
 	printk("Hello World! %s\n", CONFIG_BOARD);
 
-	if (!device_is_ready(uart_dev)) {
+	if (uart_autosuspend_init(&uart_as, uart_dev, &rx_wakeup)) {
 		return;
 	}
 
 	while(1)
 	{
-		pm_device_action_run(uart_dev, PM_DEVICE_ACTION_SUSPEND);
-		k_sleep(K_MSEC(2000));
-		printk("Should not be printed, since uart0 is disabled! %s\n", CONFIG_BOARD);
-		pm_device_action_run(uart_dev, PM_DEVICE_ACTION_RESUME);
-		k_sleep(K_MSEC(2000));
-		printk("Should be printed, since uart0 is enabled! %s\n", CONFIG_BOARD);
-	}	
+		k_sleep(K_MSEC(5000));
+		/* Suspended again CONFIG_UART_AUTOSUSPEND_IDLE_MS after this */
+		uart_autosuspend_activity(&uart_as);
+		uart_autosuspend_stats_get(&uart_as, &stats);
+		printk("%u suspends, %u RX wakeups, resume %u us, %u%% suspended\n",
+		       stats.suspends, stats.wakeups, stats.resume_latency_max_us,
+		       stats.idle_percent);
+	}
 }
@@ -8,161 +8,84 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
 
-#include <string.h>
+#include "uart_router.h"
 
-/* change this to any other UART peripheral if desired */
-
-
-#define MSG_SIZE 32
-
-/* queue to store up to 10 messages (aligned to 4-byte boundary) */
-K_MSGQ_DEFINE(uart0_msgq, MSG_SIZE, 10, 4);
-K_MSGQ_DEFINE(uart1_msgq, MSG_SIZE, 10, 4);
-
-static const struct device *uart0_dev = DEVICE_DT_GET(DT_NODELABEL(uart0));
-static const struct device *uart1_dev = DEVICE_DT_GET(DT_NODELABEL(uart1));
-
-/* receive buffer used in UART ISR callback */
-static char rx0_buf[MSG_SIZE], rx1_buf[MSG_SIZE];
-static char tx0_buf[MSG_SIZE], tx1_buf[MSG_SIZE];
-static int rx0_buf_pos, rx1_buf_pos;
-
-
-/*
- * Read characters from UART until line end is detected. Afterwards push the
- * data to the message queue.
- */
-void uart0_cb(const struct device *dev, void *user_data)
+static int routes_add(void)
 {
-	uint8_t c;
-
-	if (!uart_irq_update(uart0_dev)) {
-		return;
-	}
-
-	while (uart_irq_rx_ready(uart0_dev)) {
-
-		uart_fifo_read(uart0_dev, &c, 1);
-
-		if ((c == '\n' || c == '\r') && rx0_buf_pos > 0) {
-			/* terminate string */
-			rx0_buf[rx0_buf_pos] = '\0';
-
-			/* if queue is full, message is silently dropped */
-			k_msgq_put(&uart0_msgq, &rx0_buf, K_NO_WAIT);
-
-			/* reset the buffer (it was copied to the msgq) */
-			rx0_buf_pos = 0;
-		} else if (rx0_buf_pos < (sizeof(rx0_buf) - 1)) {
-			rx0_buf[rx0_buf_pos++] = c;
+	size_t count = uart_router_port_count();
+	int err = 0;
+
+	for (uint8_t i = 0; (i < count) && !err; i++) {
+		if (IS_ENABLED(CONFIG_UART_ROUTER_RULES_PAIRS)) {
+			/* The last port of an odd count has no partner */
+			if ((i ^ 1) < count) {
+				err = uart_router_route_add(i, i ^ 1);
+			}
+		} else if (IS_ENABLED(CONFIG_UART_ROUTER_RULES_BROADCAST)) {
+			err = uart_router_route_add(i, UART_ROUTER_ALL);
+		} else {
+			err = uart_router_route_add(i, UART_ROUTER_TAGGED);
 		}
-		/* else: characters beyond buffer size are dropped */
 	}
-}
-
-void uart1_cb(const struct device *dev, void *user_data)
-{
-	uint8_t c;
-
-	if (!uart_irq_update(uart1_dev)) {
-		return;
-	}
-
-	while (uart_irq_rx_ready(uart1_dev)) {
-
-		uart_fifo_read(uart1_dev, &c, 1);
-
-		if ((c == '\n' || c == '\r') && rx1_buf_pos > 0) {
-			/* terminate string */
-			rx0_buf[rx1_buf_pos] = '\0';
 
-			/* if queue is full, message is silently dropped */
-			k_msgq_put(&uart1_msgq, &rx1_buf, K_NO_WAIT);
-
-			/* reset the buffer (it was copied to the msgq) */
-			rx1_buf_pos = 0;
-		} else if (rx1_buf_pos < (sizeof(rx1_buf) - 1)) {
-			rx1_buf[rx1_buf_pos++] = c;
-		}
-		/* else: characters beyond buffer size are dropped */
-	}
+	return err;
 }
 
-void print_uart(const struct device * dev, char *buf)
+static void stats_print(uint32_t interval_s)
 {
-	int msg_len = strlen(buf);
-
-	for (int i = 0; i < msg_len; i++) {
-		uart_poll_out(dev, buf[i]);
+	static struct uart_router_port_stats last[UART_ROUTER_PORTS_MAX];
+	struct uart_router_port_stats now;
+
+	for (uint8_t i = 0; i < uart_router_port_count(); i++) {
+		uart_router_stats_get(i, &now);
+
+		printk("Uart%u: rx %u B/s %u lines/s, tx %u B/s %u lines/s, %u unrouted\n", i,
+		       (now.rx_bytes - last[i].rx_bytes) / interval_s,
+		       (now.rx_lines - last[i].rx_lines) / interval_s,
+		       (now.tx_bytes - last[i].tx_bytes) / interval_s,
+		       (now.tx_lines - last[i].tx_lines) / interval_s, now.unrouted);
+		printk("       rx %u B truncated, %u B no line, %u pauses, %u restart fails, "
+		       "tx %u lines %u B dropped, queue high water %u\n",
+		       now.rx_truncated_bytes, now.rx_pool_drop_bytes, now.rx_pauses,
+		       now.rx_restart_fails, now.tx_drop_lines, now.tx_drop_bytes,
+		       now.tx_queue_high_water);
+
+		last[i] = now;
 	}
-}
 
-/*
- * Print a null-terminated string character by character to the UART interface
- */
-#define PRINT_THREAD_STACK 2048
-void print_uart0_fn(void){
-	while (1)
-	{
-		/* indefinitely wait for input from the user */
-		/* Uart_0 waits Uart_1 to print*/
-		while (k_msgq_get(&uart1_msgq, &tx1_buf, K_FOREVER) == 0) {
-			print_uart(uart0_dev, "From Uart1: ");
-			print_uart(uart0_dev, tx1_buf);
-			print_uart(uart0_dev, "\r\n");
-		}
-	}
-}
-
-void print_uart1_fn(void){
-	while (1)
-	{
-		/* indefinitely wait for input from the user */
-		/* Uart_1 waits Uart_0 to print*/
-		while (k_msgq_get(&uart0_msgq, &tx0_buf, K_FOREVER) == 0) {
-			print_uart(uart1_dev, "From Uart0: ");
-			print_uart(uart1_dev, tx0_buf);
-			print_uart(uart1_dev, "\r\n");
-		}
-	}
+	printk("Line pool high water %u/%u\n", uart_router_pool_high_water(),
+	       CONFIG_UART_ROUTER_LINE_COUNT);
 }
 
-
-
 void main(void)
 {
+	char hello[32];
+	int err;
 
-	if (uart0_dev == NULL || !device_is_ready(uart0_dev)) {
-		printk("UART_0 device not found!");
+	err = uart_router_init();
+	if (err) {
+		printk("UART router setup failed (err %d)\n", err);
 		return;
-	}	
+	}
 
-	if (uart1_dev == NULL || !device_is_ready(uart1_dev)) {
-		printk("UART_1 device not found!");
+	err = routes_add();
+	if (err) {
+		printk("Routing rules failed (err %d)\n", err);
 		return;
-	}	
-
-
-	/* configure interrupt and callback to receive data */
-	uart_irq_callback_user_data_set(uart0_dev, uart0_cb, NULL);
-	uart_irq_rx_enable(uart0_dev);
-
-		/* configure interrupt and callback to receive data */
-	uart_irq_callback_user_data_set(uart1_dev, uart1_cb, NULL);
-	uart_irq_rx_enable(uart1_dev);
+	}
 
-	print_uart(uart0_dev, "Hello! This is Uart_0\r\n");
-	print_uart(uart0_dev, "Tell me something and press enter:\r\n");
+	for (uint8_t i = 0; i < uart_router_port_count(); i++) {
+		snprintk(hello, sizeof(hello), "Hello! This is Uart_%u\r\n", i);
+		uart_router_send(i, hello);
+		uart_router_send(i, "Tell me something and press enter:\r\n");
+	}
 
-	print_uart(uart1_dev, "Hello! This is Uart_1\r\n");
-	print_uart(uart1_dev, "Tell me something and press enter:\r\n");
+	if (CONFIG_UART_ROUTER_STATS_INTERVAL_S == 0) {
+		return;
+	}
 
+	while (1) {
+		k_sleep(K_SECONDS(CONFIG_UART_ROUTER_STATS_INTERVAL_S));
+		stats_print(CONFIG_UART_ROUTER_STATS_INTERVAL_S);
+	}
 }
-
-K_THREAD_DEFINE(print_uart0_thread, PRINT_THREAD_STACK,
-				print_uart0_fn, NULL, NULL, NULL,
-				K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
-
-K_THREAD_DEFINE(print_uart1_thread, PRINT_THREAD_STACK,
-				print_uart1_fn, NULL, NULL, NULL,
-				K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
\ No newline at end of file
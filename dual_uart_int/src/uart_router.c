@@ -0,0 +1,546 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/atomic.h>
+
+#include <string.h>
+
+#include "uart_router.h"
+
+#define ROUTER_NODE DT_PATH(zephyr_user)
+
+BUILD_ASSERT(DT_NODE_HAS_PROP(ROUTER_NODE, uart_router_ports),
+	     "The zephyr,user node needs a uart-router-ports property");
+
+#define PORT_DEV(node, prop, idx) DEVICE_DT_GET(DT_PHANDLE_BY_IDX(node, prop, idx)),
+
+static const struct device *const port_devs[] = {
+	DT_FOREACH_PROP_ELEM(ROUTER_NODE, uart_router_ports, PORT_DEV)
+};
+
+#define PORT_COUNT ARRAY_SIZE(port_devs)
+
+BUILD_ASSERT(PORT_COUNT <= UART_ROUTER_PORTS_MAX, "Too many UART router ports");
+
+#define RX_CHUNK_SIZE CONFIG_UART_ROUTER_RX_CHUNK_SIZE
+/* Two in use per port, plus one for the next request */
+#define RX_CHUNK_COUNT (2 * PORT_COUNT + 1)
+#define TX_QUEUE_LEN CONFIG_UART_ROUTER_TX_QUEUE_LEN
+
+struct line_buf {
+	/* Reserved for k_fifo */
+	void *fifo_reserved;
+	atomic_t refs;
+	uint8_t src;
+	/* Start of the data to send, moves when a tag is removed */
+	uint16_t start;
+	uint16_t prefix_len;
+	uint16_t len;
+	uint8_t data[UART_ROUTER_PREFIX_MAX + CONFIG_UART_ROUTER_LINE_SIZE + 2];
+};
+
+struct router_port {
+	const struct device *dev;
+	uint8_t index;
+	char prefix[UART_ROUTER_PREFIX_MAX + 1];
+	/* Line being received */
+	struct line_buf *rx_line;
+	/* Lines waiting for the TX DMA, several ports may share a line */
+	struct line_buf *tx_queue[TX_QUEUE_LEN];
+	uint8_t tx_head;
+	uint8_t tx_count;
+	/* Line being sent */
+	struct line_buf *tx_line;
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+	/* Given whenever a line leaves the TX queue */
+	struct k_sem tx_space;
+	bool rx_paused;
+	/* Paused and UART_RX_DISABLED has arrived */
+	bool rx_stopped;
+#endif
+	struct uart_router_port_stats stats;
+};
+
+static struct router_port ports[PORT_COUNT];
+static struct uart_route routes[CONFIG_UART_ROUTER_MAX_ROUTES];
+static size_t route_count;
+static uint32_t pool_high_water;
+
+K_MEM_SLAB_DEFINE_STATIC(line_slab, sizeof(struct line_buf), CONFIG_UART_ROUTER_LINE_COUNT, 4);
+K_MEM_SLAB_DEFINE_STATIC(rx_slab, RX_CHUNK_SIZE, RX_CHUNK_COUNT, 4);
+
+/* Received lines waiting for the worker */
+static K_FIFO_DEFINE(rx_fifo);
+
+static struct line_buf *line_alloc(const struct router_port *port, const char *prefix)
+{
+	struct line_buf *line;
+	size_t prefix_len = strlen(prefix);
+
+	if (k_mem_slab_alloc(&line_slab, (void **)&line, K_NO_WAIT)) {
+		return NULL;
+	}
+
+	pool_high_water = MAX(pool_high_water, CONFIG_UART_ROUTER_LINE_COUNT -
+					       k_mem_slab_num_free_get(&line_slab));
+
+	memcpy(line->data, prefix, prefix_len);
+	atomic_set(&line->refs, 1);
+	line->src = port->index;
+	line->start = 0;
+	line->prefix_len = prefix_len;
+	line->len = prefix_len;
+
+	return line;
+}
+
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+static void rx_restart(struct router_port *port);
+
+#define FLOW_LOW_WATER CONFIG_UART_ROUTER_FLOW_LOW_WATER
+#define FLOW_HIGH_WATER (2 * CONFIG_UART_ROUTER_FLOW_LOW_WATER)
+
+BUILD_ASSERT(FLOW_HIGH_WATER < CONFIG_UART_ROUTER_LINE_COUNT,
+	     "RX could never resume with this line pool");
+
+/* Stop receiving on a port, RTS follows on ports with flow control */
+static void rx_pause(struct router_port *port)
+{
+	if (!port->rx_paused) {
+		port->rx_paused = true;
+		port->stats.rx_pauses++;
+		/* Already off, no UART_RX_DISABLED will follow */
+		if (uart_rx_disable(port->dev)) {
+			port->rx_stopped = true;
+		}
+	}
+}
+
+static void rx_resume_all(void)
+{
+	if (k_mem_slab_num_free_get(&line_slab) < FLOW_HIGH_WATER) {
+		return;
+	}
+
+	for (size_t i = 0; i < PORT_COUNT; i++) {
+		if (!ports[i].rx_paused) {
+			continue;
+		}
+
+		ports[i].rx_paused = false;
+		/* Otherwise the pause is still in progress, RX then restarts
+		 * from UART_RX_DISABLED
+		 */
+		if (ports[i].rx_stopped) {
+			ports[i].rx_stopped = false;
+			rx_restart(&ports[i]);
+		}
+	}
+}
+#endif /* CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL */
+
+/* Drop one reference, the last one frees the line */
+static void line_put(struct line_buf *line)
+{
+	if (atomic_dec(&line->refs) == 1) {
+		k_mem_slab_free(&line_slab, line);
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+		unsigned int key = irq_lock();
+
+		rx_resume_all();
+		irq_unlock(key);
+#endif
+	}
+}
+
+/* A line for the port is lost to the overflow policy */
+static void tx_drop(struct router_port *port, struct line_buf *line)
+{
+	port->stats.tx_drop_lines++;
+	port->stats.tx_drop_bytes += line->len - line->start;
+	line_put(line);
+}
+
+static void tx_kick(struct router_port *port)
+{
+	unsigned int key = irq_lock();
+
+	while (!port->tx_line && port->tx_count) {
+		struct line_buf *line = port->tx_queue[port->tx_head];
+
+		port->tx_head = (port->tx_head + 1) % TX_QUEUE_LEN;
+		port->tx_count--;
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+		k_sem_give(&port->tx_space);
+#endif
+
+		port->tx_line = line;
+		if (uart_tx(port->dev, &line->data[line->start], line->len - line->start,
+			    SYS_FOREVER_US)) {
+			port->tx_line = NULL;
+			line_put(line);
+		}
+	}
+
+	irq_unlock(key);
+}
+
+/* Queue a line reference for transmission. A full queue is handled by
+ * the overflow policy, which may block the caller.
+ */
+static void tx_enqueue(struct router_port *port, struct line_buf *line)
+{
+	unsigned int key = irq_lock();
+
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+	while (port->tx_count == TX_QUEUE_LEN) {
+		k_sem_reset(&port->tx_space);
+		irq_unlock(key);
+		k_sem_take(&port->tx_space, K_FOREVER);
+		key = irq_lock();
+	}
+#elif defined(CONFIG_UART_ROUTER_OVERFLOW_DROP_OLDEST)
+	if (port->tx_count == TX_QUEUE_LEN) {
+		struct line_buf *oldest = port->tx_queue[port->tx_head];
+
+		port->tx_head = (port->tx_head + 1) % TX_QUEUE_LEN;
+		port->tx_count--;
+		tx_drop(port, oldest);
+	}
+#else
+	if (port->tx_count == TX_QUEUE_LEN) {
+		tx_drop(port, line);
+		irq_unlock(key);
+		return;
+	}
+#endif
+
+	port->tx_queue[(port->tx_head + port->tx_count) % TX_QUEUE_LEN] = line;
+	port->tx_count++;
+	port->stats.tx_queue_high_water = MAX(port->stats.tx_queue_high_water, port->tx_count);
+	irq_unlock(key);
+
+	tx_kick(port);
+}
+
+static void rx_process(struct router_port *port, const uint8_t *buf, size_t len)
+{
+	port->stats.rx_bytes += len;
+
+	for (size_t i = 0; i < len; i++) {
+		uint8_t c = buf[i];
+
+		if (c == '\n' || c == '\r') {
+			if (port->rx_line && (port->rx_line->len > port->rx_line->prefix_len)) {
+				port->stats.rx_lines++;
+				k_fifo_put(&rx_fifo, port->rx_line);
+				port->rx_line = NULL;
+			}
+			continue;
+		}
+
+		if (!port->rx_line) {
+			port->rx_line = line_alloc(port, port->prefix);
+			if (!port->rx_line) {
+				port->stats.rx_pool_drop_bytes++;
+				continue;
+			}
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+			if (k_mem_slab_num_free_get(&line_slab) < FLOW_LOW_WATER) {
+				/* Bytes already in the DMA buffer still arrive */
+				rx_pause(port);
+			}
+#endif
+		}
+
+		if ((port->rx_line->len - port->rx_line->prefix_len) <
+		    CONFIG_UART_ROUTER_LINE_SIZE) {
+			port->rx_line->data[port->rx_line->len++] = c;
+		} else {
+			port->stats.rx_truncated_bytes++;
+		}
+	}
+}
+
+static int rx_start(struct router_port *port)
+{
+	uint8_t *buf;
+	int err;
+
+	if (k_mem_slab_alloc(&rx_slab, (void **)&buf, K_NO_WAIT)) {
+		return -ENOMEM;
+	}
+
+	err = uart_rx_enable(port->dev, buf, RX_CHUNK_SIZE, CONFIG_UART_ROUTER_RX_TIMEOUT_US);
+	if (err) {
+		k_mem_slab_free(&rx_slab, buf);
+	}
+
+	return err;
+}
+
+/* Receiving stays off on failure, the port only sends from then on */
+static void rx_restart(struct router_port *port)
+{
+	if (rx_start(port)) {
+		port->stats.rx_restart_fails++;
+	}
+}
+
+static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+	struct router_port *port = user_data;
+	uint8_t *buf;
+
+	switch (evt->type) {
+	case UART_TX_DONE:
+	case UART_TX_ABORTED:
+		if (port->tx_line) {
+			port->stats.tx_bytes += evt->data.tx.len;
+			port->stats.tx_lines++;
+			line_put(port->tx_line);
+			port->tx_line = NULL;
+		}
+		tx_kick(port);
+		break;
+
+	case UART_RX_RDY:
+		rx_process(port, &evt->data.rx.buf[evt->data.rx.offset], evt->data.rx.len);
+		break;
+
+	case UART_RX_BUF_REQUEST:
+		if (!k_mem_slab_alloc(&rx_slab, (void **)&buf, K_NO_WAIT)) {
+			uart_rx_buf_rsp(dev, buf, RX_CHUNK_SIZE);
+		}
+		break;
+
+	case UART_RX_BUF_RELEASED:
+		k_mem_slab_free(&rx_slab, evt->data.rx_buf.buf);
+		break;
+
+	case UART_RX_DISABLED:
+		/* Out of buffers or after an error, receiving restarts */
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+		/* Restarted by rx_resume_all() once lines are free again */
+		if (port->rx_paused) {
+			port->rx_stopped = true;
+			break;
+		}
+#endif
+		rx_restart(port);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Parse and remove a leading "@<n> " or "@* " tag, returns the mask of
+ * destination ports
+ */
+static uint32_t tag_route(struct line_buf *line)
+{
+	char *payload = (char *)&line->data[line->prefix_len];
+	size_t payload_len = line->len - line->prefix_len;
+	uint32_t mask;
+	size_t tag_len;
+
+	if ((payload_len < 3) || (payload[0] != '@')) {
+		return 0;
+	}
+
+	if (payload[1] == '*') {
+		mask = BIT_MASK(PORT_COUNT) & ~BIT(line->src);
+		tag_len = 2;
+	} else {
+		unsigned int dst = 0;
+
+		for (tag_len = 1; (tag_len < payload_len) && (payload[tag_len] >= '0') &&
+				  (payload[tag_len] <= '9');
+		     tag_len++) {
+			dst = (dst * 10) + (payload[tag_len] - '0');
+		}
+
+		if ((tag_len == 1) || (dst >= PORT_COUNT)) {
+			return 0;
+		}
+		mask = BIT(dst);
+	}
+
+	if ((tag_len >= payload_len) || (payload[tag_len] != ' ')) {
+		return 0;
+	}
+	tag_len++;
+
+	/* Slide the prefix over the tag instead of moving the payload */
+	memmove(&line->data[tag_len], line->data, line->prefix_len);
+	line->start = tag_len;
+
+	return mask;
+}
+
+static uint32_t route_mask(struct line_buf *line)
+{
+	uint32_t mask = 0;
+
+	for (size_t i = 0; i < route_count; i++) {
+		const struct uart_route *route = &routes[i];
+
+		if (route->src != line->src) {
+			continue;
+		}
+
+		if (route->dst == UART_ROUTER_ALL) {
+			mask |= BIT_MASK(PORT_COUNT) & ~BIT(line->src);
+		} else if (route->dst == UART_ROUTER_TAGGED) {
+			mask |= tag_route(line);
+		} else {
+			mask |= BIT(route->dst);
+		}
+	}
+
+	return mask;
+}
+
+static void line_route(struct line_buf *line)
+{
+	uint32_t mask = route_mask(line);
+
+	if (!mask) {
+		ports[line->src].stats.unrouted++;
+		line_put(line);
+		return;
+	}
+
+	line->data[line->len++] = '\r';
+	line->data[line->len++] = '\n';
+
+	/* One reference per destination, the worker's own is dropped last */
+	for (size_t i = 0; i < PORT_COUNT; i++) {
+		if (mask & BIT(i)) {
+			atomic_inc(&line->refs);
+			tx_enqueue(&ports[i], line);
+		}
+	}
+
+	line_put(line);
+}
+
+static void router_thread(void)
+{
+	for (;;) {
+		struct line_buf *line = k_fifo_get(&rx_fifo, K_FOREVER);
+
+		line_route(line);
+	}
+}
+
+K_THREAD_DEFINE(router_thread_id, CONFIG_UART_ROUTER_THREAD_STACK_SIZE, router_thread,
+		NULL, NULL, NULL, CONFIG_UART_ROUTER_THREAD_PRIORITY, 0, 0);
+
+int uart_router_init(void)
+{
+	int err;
+
+	for (size_t i = 0; i < PORT_COUNT; i++) {
+		struct router_port *port = &ports[i];
+
+		if (!device_is_ready(port_devs[i])) {
+			return -ENODEV;
+		}
+
+		port->dev = port_devs[i];
+		port->index = i;
+#if defined(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)
+		k_sem_init(&port->tx_space, 0, 1);
+#endif
+		snprintk(port->prefix, sizeof(port->prefix), "From Uart%u: ", i);
+
+		err = uart_callback_set(port->dev, uart_cb, port);
+		if (err) {
+			return err;
+		}
+
+		err = rx_start(port);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+size_t uart_router_port_count(void)
+{
+	return PORT_COUNT;
+}
+
+int uart_router_route_add(uint8_t src, uint8_t dst)
+{
+	if ((src >= PORT_COUNT) ||
+	    ((dst >= PORT_COUNT) && (dst != UART_ROUTER_ALL) && (dst != UART_ROUTER_TAGGED))) {
+		return -EINVAL;
+	}
+
+	if (route_count == ARRAY_SIZE(routes)) {
+		return -ENOMEM;
+	}
+
+	/* Routes are only read by the worker, a new one is complete before
+	 * the count covers it
+	 */
+	routes[route_count] = (struct uart_route){ .src = src, .dst = dst };
+	compiler_barrier();
+	route_count++;
+
+	return 0;
+}
+
+int uart_router_send(uint8_t idx, const char *str)
+{
+	struct line_buf *line;
+	size_t len = strlen(str);
+
+	if (idx >= PORT_COUNT) {
+		return -EINVAL;
+	}
+
+	line = line_alloc(&ports[idx], "");
+	if (!line) {
+		return -ENOMEM;
+	}
+
+	if (len > sizeof(line->data)) {
+		line_put(line);
+		return -EINVAL;
+	}
+
+	memcpy(line->data, str, len);
+	line->len = len;
+
+	tx_enqueue(&ports[idx], line);
+
+	return 0;
+}
+
+int uart_router_stats_get(uint8_t idx, struct uart_router_port_stats *stats)
+{
+	if (idx >= PORT_COUNT) {
+		return -EINVAL;
+	}
+
+	unsigned int key = irq_lock();
+
+	*stats = ports[idx].stats;
+	irq_unlock(key);
+
+	return 0;
+}
+
+uint32_t uart_router_pool_high_water(void)
+{
+	return pool_high_water;
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef UART_ROUTER_H_
+#define UART_ROUTER_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+
+/*
+ * Line router between any number of UART ports on the async API.
+ *
+ * The ports are the uart-router-ports phandles of the zephyr,user node,
+ * in that order. Each port receives into pooled DMA buffers and frames
+ * lines into pooled line buffers, which already hold the prefix naming
+ * the source port. Finished lines go to a single worker thread that
+ * applies the routing rules and passes the line by pointer to the TX
+ * queue of every destination port. A line sent to several ports is
+ * reference counted and freed after the last transmission. Bytes are
+ * only copied once, from the RX buffer into the line.
+ */
+
+#define UART_ROUTER_PREFIX_MAX 16
+
+/* Destinations are kept in a 32-bit mask */
+#define UART_ROUTER_PORTS_MAX 31
+
+/* Route destination: every port but the source */
+#define UART_ROUTER_ALL 0xFF
+/* Route destination: the port named by a leading "@<n> " tag of the
+ * line, "@* " for all other ports. The tag is removed.
+ */
+#define UART_ROUTER_TAGGED 0xFE
+
+struct uart_route {
+	uint8_t src;
+	uint8_t dst;
+};
+
+struct uart_router_port_stats {
+	uint32_t rx_bytes;
+	uint32_t rx_lines;
+	uint32_t tx_bytes;
+	uint32_t tx_lines;
+	/* Received lines no route applied to */
+	uint32_t unrouted;
+	/* Received characters beyond CONFIG_UART_ROUTER_LINE_SIZE */
+	uint32_t rx_truncated_bytes;
+	/* Received characters dropped as no line buffer was free */
+	uint32_t rx_pool_drop_bytes;
+	/* Times RX was paused by flow control */
+	uint32_t rx_pauses;
+	/* Times receiving could not be restarted and stayed off */
+	uint32_t rx_restart_fails;
+	/* Lines for this port dropped by the overflow policy */
+	uint32_t tx_drop_lines;
+	uint32_t tx_drop_bytes;
+	/* Most lines that were waiting in the TX queue at once */
+	uint8_t tx_queue_high_water;
+};
+
+/* Set up every port of the table and start receiving */
+int uart_router_init(void);
+
+size_t uart_router_port_count(void);
+
+/* Add a rule, every matching rule gets a copy of the line */
+int uart_router_route_add(uint8_t src, uint8_t dst);
+
+/* Queue a string for transmission on a port */
+int uart_router_send(uint8_t port, const char *str);
+
+int uart_router_stats_get(uint8_t port, struct uart_router_port_stats *stats);
+
+/* Most line buffers that were in use at once, out of
+ * CONFIG_UART_ROUTER_LINE_COUNT
+ */
+uint32_t uart_router_pool_high_water(void);
+
+#endif /* UART_ROUTER_H_ */
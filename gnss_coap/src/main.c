@@ -15,8 +15,9 @@
 #include <date_time.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
-#include <zephyr/pm/device.h>
 #include <nrf_modem_gnss.h>
+#include <debounce.h>
+#include <uart_autosuspend.h>
 
 LOG_MODULE_REGISTER(gnss_udp, LOG_LEVEL_INF);
 
@@ -29,7 +30,7 @@ static const struct gpio_dt_spec buttons[] = {
 						{0}),
 	GPIO_DT_SPEC_GET_OR(BT2_NODE, gpios,
 						{0})};
-static struct gpio_callback button_cb_data[2];
+static struct debounce_input button_inputs[ARRAY_SIZE(buttons)];
 
 #define MESSAGE_SIZE 242
 #define MESSAGE_TO_SEND "Hello from GNSS UDP"
@@ -58,7 +59,10 @@ static struct nrf_modem_gnss_pvt_data_frame pvt_data;
 static int64_t gnss_start_time;
 static bool first_fix = false;
 
-static bool uart_state = true;
+/* uart0 RX, P0.28 on the nRF9160DK */
+static const struct gpio_dt_spec uart_wakeup =
+	GPIO_DT_SPEC_GET_OR(DT_PATH(zephyr_user), uart_wakeup_gpios, {0});
+static struct uart_autosuspend uart_as;
 
 static K_SEM_DEFINE(time_sem, 0, 1);
 static int server_resolve(void)
@@ -331,27 +335,19 @@ static void coap_put_work_fn(struct k_work *work)
 }
 K_WORK_DEFINE(coap_put_work, coap_put_work_fn);
 
-static void uart0_set_enable(bool enable)
+static void button_event(struct debounce_input *input, const struct debounce_event *evt)
 {
-	const struct device *uart_dev = DEVICE_DT_GET(DT_NODELABEL(uart0));
+	unsigned int idx = input - button_inputs;
 
-	if (!device_is_ready(uart_dev)) {
+	if (evt->type != DEBOUNCE_PRESSED) {
+		LOG_INF("Button %u released after %u ms", idx + 1, evt->duration_ms);
 		return;
 	}
 
-	pm_device_action_run(uart_dev, enable ? PM_DEVICE_ACTION_RESUME : PM_DEVICE_ACTION_SUSPEND);
-}
-
-
-void button_pressed(const struct device *dev, struct gpio_callback *cb,
-					uint32_t pins)
-{
-	int val;
+	LOG_INF("Button %u pressed at %u ms (%u bounces)", idx + 1, evt->timestamp_ms,
+		evt->bounces);
 
-	LOG_INF("Button pressed at %" PRIu32, k_cycle_get_32());
-
-	val = gpio_pin_get_dt(&buttons[0]);
-	if (val == 1 && LTE_Connection_Current_State == LTE_STATE_ON) // button1 pressed
+	if (idx == 0 && LTE_Connection_Current_State == LTE_STATE_ON)
 	{
 
 #ifndef CONFIG_GNSS_SIMULATE_FIX
@@ -366,23 +362,22 @@ void button_pressed(const struct device *dev, struct gpio_callback *cb,
 	;
 	}
 
-	val = gpio_pin_get_dt(&buttons[1]);
-	if (val == 1) // button1 pressed
+	if (idx == 1)
 	{
-		LOG_INF("Button 2 pressed.");
-		//Toogle uart_state
-		uart_state = !uart_state;
-
-		if (uart_state)
+		//Toogle the UART, it also suspends itself when idle
+		if (uart_autosuspend_is_suspended(&uart_as))
 		{
-			uart0_set_enable(true);
-			LOG_INF("UART enabled");
+			struct uart_autosuspend_stats stats;
 
+			uart_autosuspend_resume(&uart_as);
+			uart_autosuspend_stats_get(&uart_as, &stats);
+			LOG_INF("UART enabled, %u%% suspended, %u RX wakeups, resume %u us",
+				stats.idle_percent, stats.wakeups, stats.resume_latency_max_us);
 		}
 		else
 		{
 			LOG_INF("UART disabled");
-			uart0_set_enable(false);
+			uart_autosuspend_suspend(&uart_as);
 		}
 	}
 
@@ -393,25 +388,14 @@ void button_init(void)
 	int ret;
 	for (size_t i = 0; i < ARRAY_SIZE(buttons); i++)
 	{
-		ret = gpio_pin_configure_dt(&buttons[i], GPIO_INPUT);
-		if (ret != 0)
-		{
-			LOG_ERR("Error %d: failed to configure %s pin %d",
-				   ret, buttons[i].port->name, buttons[i].pin);
-			return;
-		}
-
-		ret = gpio_pin_interrupt_configure_dt(&buttons[i],
-											  GPIO_INT_EDGE_TO_ACTIVE);
+		ret = debounce_input_init(&button_inputs[i], &buttons[i], button_event);
 		if (ret != 0)
 		{
-			LOG_ERR("Error %d: failed to configure interrupt on %s pin %d",
+			LOG_ERR("Error %d: failed to set up %s pin %d",
 				   ret, buttons[i].port->name, buttons[i].pin);
 			return;
 		}
 
-		gpio_init_callback(&button_cb_data[i], button_pressed, BIT(buttons[i].pin));
-		gpio_add_callback(buttons[i].port, &button_cb_data[i]);
 		LOG_INF("Set up button at %s pin %d", buttons[i].port->name, buttons[i].pin);
 	}
 }
@@ -641,6 +625,13 @@ void main(void)
 	int received;
 	LOG_INF("UDP sample has started");
 
+	/* Before the buttons, button 2 uses the instance */
+	err = uart_autosuspend_init(&uart_as, DEVICE_DT_GET(DT_NODELABEL(uart0)), &uart_wakeup);
+	if (err)
+	{
+		LOG_ERR("UART autosuspend setup failed, error: %d", err);
+	}
+
 	button_init();
 
 	LTE_Connection_Current_State = LTE_STATE_BUSY;
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <drivers/i2c.h>
+#include <hal/nrf_gpio.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include "bus_health.h"
+
+static struct bus_health_bus buses[CONFIG_SCANNER_MAX_BUSES];
+static size_t bus_count;
+static K_MUTEX_DEFINE(stats_lock);
+
+static K_THREAD_STACK_DEFINE(monitor_stack, CONFIG_BUS_HEALTH_THREAD_STACK_SIZE);
+static struct k_thread monitor_thread;
+
+static bool sda_low(const struct bus_health_bus *bus)
+{
+	if (bus->sda_pin == BUS_HEALTH_NO_PIN) {
+		/* Devices that are gone look the same, assume nothing */
+		return false;
+	}
+
+	/* TWIM keeps the input buffer connected while it owns the pin */
+	return nrf_gpio_pin_read(bus->sda_pin) == 0;
+}
+
+static void addr_update(struct bus_health_bus *bus, struct bus_health_addr *addr,
+			int err, uint32_t latency_us)
+{
+	addr->probes++;
+
+	if (!err) {
+		if (addr->lost) {
+			printk("%s: 0x%02x back after %u failures\n", bus->dev->name,
+			       addr->addr, addr->consecutive_fails);
+		}
+		addr->lost = false;
+		addr->consecutive_fails = 0;
+		addr->latency_min_us = MIN(addr->latency_min_us, latency_us);
+		addr->latency_max_us = MAX(addr->latency_max_us, latency_us);
+		addr->latency_sum_us += latency_us;
+		return;
+	}
+
+	if (err == -EIO) {
+		addr->nacks++;
+	} else {
+		addr->errors++;
+	}
+
+	if (++addr->consecutive_fails == CONFIG_BUS_HEALTH_FAIL_THRESHOLD) {
+		addr->lost = true;
+		printk("%s: 0x%02x lost (err %d)\n", bus->dev->name, addr->addr, err);
+	}
+}
+
+static void bus_recover(struct bus_health_bus *bus)
+{
+	/* Recovery clocks the bus for a while, bus_health_get() is not held
+	 * up meanwhile
+	 */
+	int err = i2c_recover_bus(bus->dev);
+
+	k_mutex_lock(&stats_lock, K_FOREVER);
+	bus->stuck++;
+	if (err) {
+		bus->recovery_fails++;
+	} else {
+		bus->recoveries++;
+	}
+	k_mutex_unlock(&stats_lock);
+
+	if (err) {
+		printk("%s: bus stuck, recovery failed (err %d)\n", bus->dev->name, err);
+	} else {
+		printk("%s: bus stuck, recovered\n", bus->dev->name);
+	}
+}
+
+static void bus_round(struct bus_health_bus *bus)
+{
+	bool any_ok = false;
+
+	for (size_t i = 0; i < bus->addr_count; i++) {
+		struct bus_health_addr *addr = &bus->addrs[i];
+		uint32_t start = k_cycle_get_32();
+		int err = scanner_probe(bus->dev, addr->addr);
+		uint32_t latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+		k_mutex_lock(&stats_lock, K_FOREVER);
+		addr_update(bus, addr, err, latency_us);
+		k_mutex_unlock(&stats_lock);
+
+		any_ok |= (err == 0);
+	}
+
+	k_mutex_lock(&stats_lock, K_FOREVER);
+	bus->rounds++;
+	k_mutex_unlock(&stats_lock);
+
+	if (!any_ok && bus->addr_count && sda_low(bus)) {
+		bus_recover(bus);
+	}
+}
+
+static void report_print(void)
+{
+	struct bus_health_bus bus;
+
+	for (size_t i = 0; i < bus_health_bus_count(); i++) {
+		bus_health_get(i, &bus);
+
+		printk("%s: %u rounds, %u stuck, %u recovered, %u recovery failures\n",
+		       bus.dev->name, bus.rounds, bus.stuck, bus.recoveries,
+		       bus.recovery_fails);
+
+		for (size_t j = 0; j < bus.addr_count; j++) {
+			const struct bus_health_addr *addr = &bus.addrs[j];
+
+			printk("  0x%02x%s probes %u nack %u err %u latency %u/%u/%u us\n",
+			       addr->addr, addr->lost ? " LOST" : "", addr->probes,
+			       addr->nacks, addr->errors,
+			       (addr->latency_min_us == UINT32_MAX) ? 0 : addr->latency_min_us,
+			       bus_health_latency_avg_us(addr), addr->latency_max_us);
+		}
+	}
+}
+
+static void monitor(void *p1, void *p2, void *p3)
+{
+	uint32_t rounds = 0;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		k_sleep(K_MSEC(CONFIG_BUS_HEALTH_INTERVAL_MS));
+
+		for (size_t i = 0; i < bus_count; i++) {
+			bus_round(&buses[i]);
+		}
+
+		if (CONFIG_BUS_HEALTH_REPORT_ROUNDS &&
+		    (++rounds % CONFIG_BUS_HEALTH_REPORT_ROUNDS) == 0) {
+			report_print();
+		}
+	}
+}
+
+int bus_health_add(const struct scanner_result *result, int sda_pin)
+{
+	struct bus_health_bus *bus;
+
+	if (result->err) {
+		return result->err;
+	}
+
+	if (bus_count == ARRAY_SIZE(buses)) {
+		return -ENOMEM;
+	}
+
+	bus = &buses[bus_count];
+	memset(bus, 0, sizeof(*bus));
+	bus->dev = result->bus;
+	bus->sda_pin = sda_pin;
+	bus->addr_count = MIN(result->found, ARRAY_SIZE(bus->addrs));
+
+	for (size_t i = 0; i < bus->addr_count; i++) {
+		bus->addrs[i].addr = result->devices[i].addr;
+		bus->addrs[i].latency_min_us = UINT32_MAX;
+	}
+
+	bus_count++;
+
+	return 0;
+}
+
+void bus_health_start(void)
+{
+	k_thread_create(&monitor_thread, monitor_stack,
+			K_THREAD_STACK_SIZEOF(monitor_stack), monitor, NULL, NULL, NULL,
+			CONFIG_BUS_HEALTH_THREAD_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&monitor_thread, "bus_health");
+}
+
+size_t bus_health_bus_count(void)
+{
+	return bus_count;
+}
+
+int bus_health_get(size_t idx, struct bus_health_bus *bus)
+{
+	if (idx >= bus_count) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&stats_lock, K_FOREVER);
+	*bus = buses[idx];
+	k_mutex_unlock(&stats_lock);
+
+	return 0;
+}
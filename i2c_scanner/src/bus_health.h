@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BUS_HEALTH_H_
+#define BUS_HEALTH_H_
+
+#include <zephyr.h>
+#include <device.h>
+
+#include "scanner.h"
+
+/* SDA pin of a bus that cannot be sampled */
+#define BUS_HEALTH_NO_PIN -1
+
+struct bus_health_addr {
+	uint8_t addr;
+	bool lost;
+	uint16_t consecutive_fails;
+	uint32_t probes;
+	/* -EIO, which is all a TWIM NACK can be told apart by */
+	uint32_t nacks;
+	/* Any other probe error */
+	uint32_t errors;
+	/* Latency of the acknowledged probes */
+	uint32_t latency_min_us;
+	uint32_t latency_max_us;
+	uint64_t latency_sum_us;
+};
+
+struct bus_health_bus {
+	const struct device *dev;
+	int sda_pin;
+	uint32_t rounds;
+	/* Rounds where no device answered and SDA was low */
+	uint32_t stuck;
+	uint32_t recoveries;
+	uint32_t recovery_fails;
+	uint8_t addr_count;
+	struct bus_health_addr addrs[CONFIG_SCANNER_MAX_DEVICES];
+};
+
+/*
+ * Monitor the devices a scan found. sda_pin is sampled to tell a stuck
+ * bus from devices that are gone. Without it a stuck bus cannot be told
+ * apart and the bus is never recovered.
+ */
+int bus_health_add(const struct scanner_result *result, int sda_pin);
+
+/* Start the monitor thread once all buses are added */
+void bus_health_start(void);
+
+size_t bus_health_bus_count(void);
+
+/* Copy the counters of a bus */
+int bus_health_get(size_t idx, struct bus_health_bus *bus);
+
+static inline uint32_t bus_health_latency_avg_us(const struct bus_health_addr *addr)
+{
+	uint32_t acked = addr->probes - addr->nacks - addr->errors;
+
+	return acked ? (uint32_t)(addr->latency_sum_us / acked) : 0;
+}
+
+#endif /* BUS_HEALTH_H_ */
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#if __has_include(<zephyr/drivers/i2c.h>)
+#include <zephyr/drivers/i2c.h>
+#else
+#include <drivers/i2c.h>
+#endif
+
+#include "fingerprint.h"
+
+struct fingerprint {
+	/* Address range the part can be strapped to */
+	uint8_t addr_min;
+	uint8_t addr_max;
+	uint8_t reg;
+	/* 1 or 2, 16-bit IDs are big endian */
+	uint8_t width;
+	uint16_t mask;
+	uint16_t id;
+	const char *name;
+};
+
+#define FP(_min, _max, _reg, _width, _mask, _id, _name)                        \
+	{                                                                      \
+		.addr_min = _min, .addr_max = _max, .reg = _reg,               \
+		.width = _width, .mask = _mask, .id = _id, .name = _name,      \
+	}
+
+/* Parts sharing a register are kept together, it is read once */
+static const struct fingerprint fingerprints[] = {
+	FP(0x18, 0x19, 0x0F, 1, 0xFF, 0x33, "LIS3DH/LIS2DH12"),
+	FP(0x1C, 0x1D, 0x0F, 1, 0xFF, 0x3D, "LIS3MDL"),
+	FP(0x1C, 0x1D, 0x0D, 1, 0xFF, 0x2A, "MMA8452Q"),
+	FP(0x1E, 0x1E, 0x0A, 1, 0xFF, 'H', "HMC5883L"),
+	FP(0x29, 0x29, 0xC0, 1, 0xFF, 0xEE, "VL53L0X"),
+	FP(0x38, 0x39, 0x40, 1, 0x3F, 0x0D, "BH1749"),
+	FP(0x40, 0x43, 0xFF, 2, 0xFFFF, 0x1050, "HDC1080"),
+	FP(0x48, 0x4B, 0x0F, 2, 0x0FFF, 0x0117, "TMP117"),
+	FP(0x5C, 0x5D, 0x0F, 1, 0xFF, 0xB1, "LPS22HB"),
+	FP(0x5C, 0x5D, 0x0F, 1, 0xFF, 0xB3, "LPS22HH"),
+	FP(0x5C, 0x5D, 0x0F, 1, 0xFF, 0xBD, "LPS25H"),
+	FP(0x68, 0x69, 0x75, 1, 0xFF, 0x68, "MPU-6050"),
+	FP(0x68, 0x69, 0x75, 1, 0xFF, 0x70, "MPU-6500"),
+	FP(0x68, 0x69, 0x75, 1, 0xFF, 0x71, "MPU-9250"),
+	FP(0x68, 0x69, 0x00, 1, 0xFF, 0xD1, "BMI160"),
+	FP(0x68, 0x69, 0x00, 1, 0xFF, 0xEA, "ICM-20948"),
+	FP(0x6A, 0x6B, 0x0F, 1, 0xFF, 0x69, "LSM6DS3"),
+	FP(0x6A, 0x6B, 0x0F, 1, 0xFF, 0x6A, "LSM6DSL"),
+	FP(0x6A, 0x6B, 0x0F, 1, 0xFF, 0x6C, "LSM6DSO"),
+	FP(0x76, 0x77, 0xD0, 1, 0xFF, 0x55, "BMP180"),
+	FP(0x76, 0x77, 0xD0, 1, 0xFF, 0x58, "BMP280"),
+	FP(0x76, 0x77, 0xD0, 1, 0xFF, 0x60, "BME280"),
+	FP(0x76, 0x77, 0xD0, 1, 0xFF, 0x61, "BME680"),
+};
+
+static int id_read(const struct device *bus, uint8_t addr, uint8_t reg,
+		   uint8_t width, uint16_t *id)
+{
+	uint8_t buf[2];
+	int err;
+
+	err = i2c_write_read(bus, addr, &reg, sizeof(reg), buf, width);
+	if (err) {
+		return err;
+	}
+
+	*id = (width == 2) ? ((buf[0] << 8) | buf[1]) : buf[0];
+
+	return 0;
+}
+
+const char *fingerprint_identify(const struct device *bus, uint8_t addr)
+{
+	const struct fingerprint *last = NULL;
+	uint16_t id = 0;
+	int err = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(fingerprints); i++) {
+		const struct fingerprint *fp = &fingerprints[i];
+
+		if ((addr < fp->addr_min) || (addr > fp->addr_max)) {
+			continue;
+		}
+
+		if (!last || (last->reg != fp->reg) || (last->width != fp->width)) {
+			err = id_read(bus, addr, fp->reg, fp->width, &id);
+			last = fp;
+		}
+
+		if (!err && ((id & fp->mask) == fp->id)) {
+			return fp->name;
+		}
+	}
+
+	return NULL;
+}
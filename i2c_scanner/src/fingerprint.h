@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FINGERPRINT_H_
+#define FINGERPRINT_H_
+
+/* Also built by tests/i2c_scanner, which needs the prefixed headers */
+#if __has_include(<zephyr/kernel.h>)
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#else
+#include <zephyr.h>
+#include <device.h>
+#endif
+
+/*
+ * Name the part at addr by reading the ID registers of the parts that
+ * may sit at that address. Returns NULL when none matches.
+ */
+const char *fingerprint_identify(const struct device *bus, uint8_t addr);
+
+#endif /* FINGERPRINT_H_ */
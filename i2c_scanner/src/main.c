@@ -8,50 +8,106 @@
 
 #include <zephyr.h>
 #include <sys/printk.h>
-#include <drivers/i2c.h>
-#include <string.h>
-#include <stdlib.h>
-#include <math.h>
-#include <drivers/gpio.h>
+#include <device.h>
 
-#define I2C_DEV DT_NODELABEL(arduino_i2c)
+#include "scanner.h"
+#include "bus_health.h"
+
+struct bus_desc {
+	const char *label;
+	int sda_pin;
+};
+
+#define BUS_DESC(node)                                                         \
+	{                                                                      \
+		.label = DT_LABEL(node),                                       \
+		.sda_pin = DT_PROP_OR(node, sda_pin, BUS_HEALTH_NO_PIN),       \
+	},
+
+/* Every enabled TWI/TWIM instance is scanned */
+static const struct bus_desc bus_descs[] = {
+	DT_FOREACH_STATUS_OKAY(nordic_nrf_twim, BUS_DESC)
+	DT_FOREACH_STATUS_OKAY(nordic_nrf_twi, BUS_DESC)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(bus_descs) > 0, "No I2C bus enabled");
+
+static struct scanner_result results[ARRAY_SIZE(bus_descs)];
+
+static void result_print(const struct scanner_result *result)
+{
+	if (result->err) {
+		printk("%s: scan failed (err %d)\n", result->bus->name, result->err);
+		return;
+	}
+
+	printk("%s: %u device(s) at %u kHz, probe %u us, total %u us\n",
+	       result->bus->name, result->found, result->speed_hz / 1000,
+	       result->probe_us, result->scan_us);
+
+	for (size_t i = 0; i < MIN(result->found, ARRAY_SIZE(result->devices)); i++) {
+		const struct scanner_device *dev = &result->devices[i];
+
+		printk("  0x%02x FOUND %s\n", dev->addr, dev->name ? dev->name : "");
+	}
+
+	if (result->found > ARRAY_SIZE(result->devices)) {
+		printk("  %u more not recorded\n",
+		       result->found - ARRAY_SIZE(result->devices));
+	}
+}
 
 void main(void)
 {
-	const struct device *i2c_dev;
-	
+	const struct device *buses[ARRAY_SIZE(bus_descs)];
+	int sda_pins[ARRAY_SIZE(bus_descs)];
+	size_t count = 0;
+	uint32_t total_us;
+	int err;
+
 	k_sleep(K_SECONDS(1));
 
-	printk("Starting i2c scanner at %s\n", DT_LABEL(I2C_DEV));
+	for (size_t i = 0; i < ARRAY_SIZE(bus_descs); i++) {
+		const struct device *bus = device_get_binding(bus_descs[i].label);
+
+		if (!bus) {
+			printk("%s: device driver not found\n", bus_descs[i].label);
+			continue;
+		}
+
+		if (count == CONFIG_SCANNER_MAX_BUSES) {
+			printk("%s: skipped, raise CONFIG_SCANNER_MAX_BUSES\n", bus_descs[i].label);
+			continue;
+		}
+
+		sda_pins[count] = bus_descs[i].sda_pin;
+		buses[count++] = bus;
+	}
+
+	printk("Starting i2c scanner on %u bus(es)\n", count);
 
-	i2c_dev = device_get_binding(DT_LABEL(I2C_DEV));
-	if (!i2c_dev) {
-		printk("I2C: Device driver not found.\n");
+	err = scanner_scan_all(buses, count, results, &total_us);
+	if (err) {
+		printk("Scan failed (err %d)\n", err);
 		return;
 	}
-	
-	uint8_t error = 0u;
-	
-	i2c_configure(i2c_dev, I2C_SPEED_SET(I2C_SPEED_STANDARD));
-	
-	for (uint8_t i = 4; i <= 0x77; i++) {
-		struct i2c_msg msgs[1];
-		uint8_t dst = 1;
-
-		/* Send the address to read from */
-		msgs[0].buf = &dst;
-		msgs[0].len = 1U;
-		msgs[0].flags = I2C_MSG_WRITE | I2C_MSG_STOP;
-		
-		error = i2c_transfer(i2c_dev, &msgs[0], 1, i);
-		if (error == 0) {
-			printk("0x%2x FOUND\n", i);
-		}
-		else {
-			//printk("error %d \n", error);
+
+	for (size_t i = 0; i < count; i++) {
+		result_print(&results[i]);
+	}
+
+	printk("Scanning done in %u us\n", total_us);
+
+#if defined(CONFIG_BUS_HEALTH)
+	for (size_t i = 0; i < count; i++) {
+		err = bus_health_add(&results[i], sda_pins[i]);
+		if (err) {
+			printk("%s: not monitored (err %d)\n", buses[i]->name, err);
 		}
-		
 	}
-	printk("Scanning done\n");
-	
-}
\ No newline at end of file
+
+	bus_health_start();
+#else
+	ARG_UNUSED(sda_pins);
+#endif
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#if __has_include(<zephyr/drivers/i2c.h>)
+#include <zephyr/drivers/i2c.h>
+#else
+#include <drivers/i2c.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "scanner.h"
+#if defined(CONFIG_SCANNER_FINGERPRINT)
+#include "fingerprint.h"
+#endif
+
+struct bus_speed {
+	uint32_t speed;
+	uint32_t hz;
+};
+
+/* Fastest first */
+static const struct bus_speed speeds[] = {
+#if defined(CONFIG_SCANNER_FAST_PLUS)
+	{ I2C_SPEED_FAST_PLUS, 1000000 },
+#endif
+	{ I2C_SPEED_FAST, 400000 },
+	{ I2C_SPEED_STANDARD, 100000 },
+};
+
+static K_THREAD_STACK_ARRAY_DEFINE(scan_stacks, CONFIG_SCANNER_MAX_BUSES,
+				   CONFIG_SCANNER_THREAD_STACK_SIZE);
+static struct k_thread scan_threads[CONFIG_SCANNER_MAX_BUSES];
+
+static uint32_t cycles_to_us(uint32_t start)
+{
+	return k_cyc_to_us_floor32(k_cycle_get_32() - start);
+}
+
+static int bus_configure(const struct device *bus, uint32_t *hz)
+{
+	int err = -ENOTSUP;
+
+	for (size_t i = 0; i < ARRAY_SIZE(speeds); i++) {
+		err = i2c_configure(bus, I2C_MODE_MASTER | I2C_SPEED_SET(speeds[i].speed));
+		if (!err) {
+			*hz = speeds[i].hz;
+			return 0;
+		}
+	}
+
+	return err;
+}
+
+int scanner_probe(const struct device *bus, uint8_t addr)
+{
+	uint8_t dummy;
+	struct i2c_msg msg = {
+		.buf = &dummy,
+		.len = sizeof(dummy),
+		.flags = I2C_MSG_READ | I2C_MSG_STOP,
+	};
+
+	return i2c_transfer(bus, &msg, 1, addr);
+}
+
+int scanner_scan(const struct device *bus, struct scanner_result *result)
+{
+	uint32_t start;
+	int err;
+
+	memset(result, 0, sizeof(*result));
+	result->bus = bus;
+
+	err = bus_configure(bus, &result->speed_hz);
+	if (err) {
+		result->err = err;
+		return err;
+	}
+
+	start = k_cycle_get_32();
+
+	for (uint8_t addr = SCANNER_ADDR_FIRST; addr <= SCANNER_ADDR_LAST; addr++) {
+		if (scanner_probe(bus, addr)) {
+			continue;
+		}
+
+		if (result->found < ARRAY_SIZE(result->devices)) {
+			result->devices[result->found].addr = addr;
+		}
+		result->found++;
+	}
+
+	result->probe_us = cycles_to_us(start);
+
+#if defined(CONFIG_SCANNER_FINGERPRINT)
+	size_t recorded = MIN(result->found, ARRAY_SIZE(result->devices));
+
+	for (size_t i = 0; i < recorded; i++) {
+		struct scanner_device *dev = &result->devices[i];
+
+		dev->name = fingerprint_identify(bus, dev->addr);
+	}
+#endif
+
+	result->scan_us = cycles_to_us(start);
+
+	return 0;
+}
+
+static void scan_thread(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p3);
+
+	scanner_scan(p1, p2);
+}
+
+int scanner_scan_all(const struct device *const *buses, size_t count,
+		     struct scanner_result *results, uint32_t *total_us)
+{
+	uint32_t start;
+
+	if (count > CONFIG_SCANNER_MAX_BUSES) {
+		return -EINVAL;
+	}
+
+	start = k_cycle_get_32();
+
+	for (size_t i = 0; i < count; i++) {
+		k_thread_create(&scan_threads[i], scan_stacks[i],
+				K_THREAD_STACK_SIZEOF(scan_stacks[i]), scan_thread,
+				(void *)buses[i], &results[i], NULL,
+				CONFIG_SCANNER_THREAD_PRIORITY, 0, K_NO_WAIT);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		k_thread_join(&scan_threads[i], K_FOREVER);
+	}
+
+	*total_us = cycles_to_us(start);
+
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SCANNER_H_
+#define SCANNER_H_
+
+/* Also built by tests/i2c_scanner, which needs the prefixed headers */
+#if __has_include(<zephyr/kernel.h>)
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#else
+#include <zephyr.h>
+#include <device.h>
+#endif
+
+/* 7-bit addresses outside the reserved ranges */
+#define SCANNER_ADDR_FIRST 0x04
+#define SCANNER_ADDR_LAST 0x77
+
+struct scanner_device {
+	uint8_t addr;
+	/* Fingerprinted part, NULL when unknown */
+	const char *name;
+};
+
+struct scanner_result {
+	const struct device *bus;
+	/* Bus speed the scan ran at */
+	uint32_t speed_hz;
+	/* 0, or the error that stopped the scan */
+	int err;
+	/* Responding addresses, only the first CONFIG_SCANNER_MAX_DEVICES
+	 * are recorded
+	 */
+	uint8_t found;
+	struct scanner_device devices[CONFIG_SCANNER_MAX_DEVICES];
+	/* Address probing only */
+	uint32_t probe_us;
+	/* Probing and fingerprinting */
+	uint32_t scan_us;
+};
+
+/*
+ * Scan one bus from the calling thread.
+ *
+ * The bus is configured at the fastest speed the controller accepts and
+ * left there. Every address gets a 1-byte read. Unlike a write it does not
+ * move the register pointer, but the part returns the byte at its current
+ * pointer, so a FIFO or clear-on-read register there loses that byte.
+ */
+int scanner_scan(const struct device *bus, struct scanner_result *result);
+
+/*
+ * Probe a single address with a 1-byte read. Returns 0 when it is
+ * acknowledged, otherwise the i2c_transfer() error.
+ */
+int scanner_probe(const struct device *bus, uint8_t addr);
+
+/*
+ * Scan up to CONFIG_SCANNER_MAX_BUSES buses at the same time, one thread
+ * per bus, and wait for all of them. total_us is the wall time of the
+ * whole scan.
+ */
+int scanner_scan_all(const struct device *const *buses, size_t count,
+		     struct scanner_result *results, uint32_t *total_us);
+
+#endif /* SCANNER_H_ */
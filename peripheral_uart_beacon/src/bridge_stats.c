@@ -0,0 +1,248 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file
+ *  @brief UART to BLE bridge statistics implementation
+ */
+#include "bridge_stats.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/shell/shell.h>
+
+#include <string.h>
+
+/* The characteristic exposes the statistics structure as it is */
+BUILD_ASSERT(IS_ENABLED(CONFIG_LITTLE_ENDIAN));
+
+#define BT_UUID_BRIDGE_STATS_SERVICE_VAL \
+	BT_UUID_128_ENCODE(0x6e400010, 0xb5a3, 0xf393, 0xe0a9, 0xe50e24dcca9e)
+#define BT_UUID_BRIDGE_STATS_CHAR_VAL \
+	BT_UUID_128_ENCODE(0x6e400011, 0xb5a3, 0xf393, 0xe0a9, 0xe50e24dcca9e)
+
+#define BT_UUID_BRIDGE_STATS_SERVICE BT_UUID_DECLARE_128(BT_UUID_BRIDGE_STATS_SERVICE_VAL)
+#define BT_UUID_BRIDGE_STATS_CHAR BT_UUID_DECLARE_128(BT_UUID_BRIDGE_STATS_CHAR_VAL)
+
+/* Counters updated from the UART callback */
+static atomic_t uart_rx_bytes;
+static atomic_t alloc_failures;
+static atomic_t rx_queue_depth;
+static atomic_t rx_queue_max;
+static atomic_t tx_queue_depth;
+static atomic_t tx_queue_max;
+
+/* Counters updated from the BLE write thread and, for the slots, the
+ * Bluetooth RX thread on connection parameter updates. They are also
+ * read and cleared from the shell and GATT, all under lock.
+ */
+static struct k_spinlock lock;
+static uint32_t ble_tx_bytes;
+static uint32_t ble_tx_notif;
+static uint32_t latency_hist[BRIDGE_STATS_LATENCY_BUCKETS];
+static uint32_t notif_hist[BRIDGE_STATS_NOTIF_BUCKETS];
+
+/* Notifications are grouped by connection interval sized time slots, as
+ * the host does not report the actual connection events.
+ */
+static uint32_t conn_interval_us;
+static uint32_t notif_slot;
+static uint32_t notif_in_slot;
+
+static void queue_depth_inc(atomic_t *depth, atomic_t *max)
+{
+	atomic_val_t val = atomic_inc(depth) + 1;
+	atomic_val_t old = atomic_get(max);
+
+	while ((val > old) && !atomic_cas(max, old, val)) {
+		old = atomic_get(max);
+	}
+}
+
+void bridge_stats_uart_rx(size_t len)
+{
+	atomic_add(&uart_rx_bytes, len);
+}
+
+void bridge_stats_alloc_failed(void)
+{
+	atomic_inc(&alloc_failures);
+}
+
+void bridge_stats_rx_queue_put(void)
+{
+	queue_depth_inc(&rx_queue_depth, &rx_queue_max);
+}
+
+void bridge_stats_rx_queue_get(void)
+{
+	atomic_dec(&rx_queue_depth);
+}
+
+void bridge_stats_tx_queue_put(void)
+{
+	queue_depth_inc(&tx_queue_depth, &tx_queue_max);
+}
+
+void bridge_stats_tx_queue_get(void)
+{
+	atomic_dec(&tx_queue_depth);
+}
+
+static void notif_slot_close(void)
+{
+	if (notif_in_slot) {
+		notif_hist[MIN(notif_in_slot, BRIDGE_STATS_NOTIF_BUCKETS) - 1]++;
+	}
+	notif_in_slot = 0;
+}
+
+void bridge_stats_ble_tx(size_t len, uint32_t rx_timestamp)
+{
+	uint32_t now = k_cycle_get_32();
+	uint32_t latency_ms = k_cyc_to_ms_floor32(now - rx_timestamp);
+	size_t bucket = 0;
+	k_spinlock_key_t key;
+
+	while ((latency_ms >> bucket) && (bucket < (BRIDGE_STATS_LATENCY_BUCKETS - 1))) {
+		bucket++;
+	}
+
+	key = k_spin_lock(&lock);
+
+	ble_tx_bytes += len;
+	ble_tx_notif++;
+	latency_hist[bucket]++;
+
+	if (conn_interval_us) {
+		uint32_t slot = k_cyc_to_us_floor32(now) / conn_interval_us;
+
+		if (slot != notif_slot) {
+			notif_slot_close();
+			notif_slot = slot;
+		}
+		notif_in_slot++;
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+void bridge_stats_conn_interval_set(uint16_t interval)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	notif_slot_close();
+	/* Connection interval is in units of 1.25 ms */
+	conn_interval_us = interval * 1250U;
+
+	k_spin_unlock(&lock, key);
+}
+
+void bridge_stats_get(struct bridge_stats *stats)
+{
+	stats->uart_rx_bytes = atomic_get(&uart_rx_bytes);
+	stats->alloc_failures = atomic_get(&alloc_failures);
+	stats->rx_queue_depth = atomic_get(&rx_queue_depth);
+	stats->rx_queue_max = atomic_get(&rx_queue_max);
+	stats->tx_queue_depth = atomic_get(&tx_queue_depth);
+	stats->tx_queue_max = atomic_get(&tx_queue_max);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats->ble_tx_bytes = ble_tx_bytes;
+	stats->ble_tx_notif = ble_tx_notif;
+	memcpy(stats->latency_hist, latency_hist, sizeof(latency_hist));
+	memcpy(stats->notif_hist, notif_hist, sizeof(notif_hist));
+
+	k_spin_unlock(&lock, key);
+}
+
+void bridge_stats_reset(void)
+{
+	atomic_clear(&uart_rx_bytes);
+	atomic_clear(&alloc_failures);
+	/* Current depths stay valid, the maximums restart from them */
+	atomic_set(&rx_queue_max, atomic_get(&rx_queue_depth));
+	atomic_set(&tx_queue_max, atomic_get(&tx_queue_depth));
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	ble_tx_bytes = 0;
+	ble_tx_notif = 0;
+	notif_in_slot = 0;
+	memset(latency_hist, 0, sizeof(latency_hist));
+	memset(notif_hist, 0, sizeof(notif_hist));
+
+	k_spin_unlock(&lock, key);
+}
+
+static ssize_t read_stats(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t len, uint16_t offset)
+{
+	struct bridge_stats stats;
+
+	bridge_stats_get(&stats);
+
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, &stats, sizeof(stats));
+}
+
+BT_GATT_SERVICE_DEFINE(bridge_stats_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_BRIDGE_STATS_SERVICE),
+	BT_GATT_CHARACTERISTIC(BT_UUID_BRIDGE_STATS_CHAR,
+			       BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ,
+			       read_stats, NULL, NULL),
+);
+
+#ifdef CONFIG_BT_NUS_BRIDGE_STATS_SHELL
+static int cmd_stats_show(const struct shell *sh, size_t argc, char **argv)
+{
+	struct bridge_stats stats;
+
+	bridge_stats_get(&stats);
+
+	shell_print(sh, "UART RX bytes:   %u", stats.uart_rx_bytes);
+	shell_print(sh, "BLE TX bytes:    %u", stats.ble_tx_bytes);
+	shell_print(sh, "BLE TX notif:    %u", stats.ble_tx_notif);
+	shell_print(sh, "Alloc failures:  %u", stats.alloc_failures);
+	shell_print(sh, "RX queue:        %u (max %u)", stats.rx_queue_depth, stats.rx_queue_max);
+	shell_print(sh, "TX queue:        %u (max %u)", stats.tx_queue_depth, stats.tx_queue_max);
+
+	shell_print(sh, "Latency:");
+	for (size_t i = 0; i < BRIDGE_STATS_LATENCY_BUCKETS; i++) {
+		if (i == (BRIDGE_STATS_LATENCY_BUCKETS - 1)) {
+			shell_print(sh, "  >= %4u ms: %u", (unsigned int)BIT(i - 1), stats.latency_hist[i]);
+		} else {
+			shell_print(sh, "  <  %4u ms: %u", (unsigned int)BIT(i), stats.latency_hist[i]);
+		}
+	}
+
+	shell_print(sh, "Notifications per connection interval:");
+	for (size_t i = 0; i < BRIDGE_STATS_NOTIF_BUCKETS; i++) {
+		shell_print(sh, "  %zu%s: %u", i + 1,
+			    (i == (BRIDGE_STATS_NOTIF_BUCKETS - 1)) ? "+" : "",
+			    stats.notif_hist[i]);
+	}
+
+	return 0;
+}
+
+static int cmd_stats_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	bridge_stats_reset();
+	shell_print(sh, "Bridge statistics cleared");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_bridge,
+	SHELL_CMD(stats, NULL, "Show bridge statistics", cmd_stats_show),
+	SHELL_CMD(reset, NULL, "Clear bridge statistics", cmd_stats_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(bridge, &sub_bridge, "NUS bridge commands", NULL);
+#endif /* CONFIG_BT_NUS_BRIDGE_STATS_SHELL */
@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file
+ *  @brief UART to BLE bridge statistics
+ */
+
+#ifndef BRIDGE_STATS_H_
+#define BRIDGE_STATS_H_
+
+/**
+ * @brief UART to BLE bridge statistics
+ * @defgroup bridge_stats Bridge statistics
+ * @{
+ *
+ * Counters and histograms describing the NUS bridge throughput and
+ * latency. The hooks compile to nothing when
+ * CONFIG_BT_NUS_BRIDGE_STATS is disabled.
+ */
+
+#include <zephyr/kernel.h>
+
+/** Number of buckets of the latency histogram */
+#define BRIDGE_STATS_LATENCY_BUCKETS 10
+
+/** Number of buckets of the notifications per connection event histogram */
+#define BRIDGE_STATS_NOTIF_BUCKETS 4
+
+/**
+ * @brief Snapshot of the bridge statistics
+ *
+ * This is also the little-endian layout of the statistics characteristic.
+ */
+struct bridge_stats {
+	/** Bytes received from UART */
+	uint32_t uart_rx_bytes;
+	/** Bytes sent over BLE */
+	uint32_t ble_tx_bytes;
+	/** Notifications sent over BLE */
+	uint32_t ble_tx_notif;
+	/** Buffer allocation failures in both directions */
+	uint32_t alloc_failures;
+	/** Current number of elements in the UART RX queue */
+	uint16_t rx_queue_depth;
+	/** Highest number of elements seen in the UART RX queue */
+	uint16_t rx_queue_max;
+	/** Current number of elements in the UART TX queue */
+	uint16_t tx_queue_depth;
+	/** Highest number of elements seen in the UART TX queue */
+	uint16_t tx_queue_max;
+	/** UART RX to bt_nus_send return latency. Bucket 0 counts latencies
+	 *  below 1 ms, bucket n below 2^n ms, the last one everything above.
+	 */
+	uint32_t latency_hist[BRIDGE_STATS_LATENCY_BUCKETS];
+	/** Notifications sent within one connection interval. Bucket n counts
+	 *  intervals with n + 1 notifications, the last one also more.
+	 */
+	uint32_t notif_hist[BRIDGE_STATS_NOTIF_BUCKETS];
+} __packed;
+
+#ifdef CONFIG_BT_NUS_BRIDGE_STATS
+
+void bridge_stats_uart_rx(size_t len);
+void bridge_stats_ble_tx(size_t len, uint32_t rx_timestamp);
+void bridge_stats_alloc_failed(void);
+void bridge_stats_rx_queue_put(void);
+void bridge_stats_rx_queue_get(void);
+void bridge_stats_tx_queue_put(void);
+void bridge_stats_tx_queue_get(void);
+
+/**
+ * @brief Set the interval used to group notifications into events
+ *
+ * @param interval Connection interval in units of 1.25 ms, 0 when not
+ *                 connected.
+ */
+void bridge_stats_conn_interval_set(uint16_t interval);
+
+/**
+ * @brief Get a snapshot of the statistics
+ *
+ * @param stats Structure to store the statistics in
+ */
+void bridge_stats_get(struct bridge_stats *stats);
+
+/** @brief Clear all counters and histograms */
+void bridge_stats_reset(void);
+
+/** @brief Timestamp taken when data is received from UART */
+static inline uint32_t bridge_stats_timestamp(void)
+{
+	return k_cycle_get_32();
+}
+
+#else
+
+static inline void bridge_stats_uart_rx(size_t len) {}
+static inline void bridge_stats_ble_tx(size_t len, uint32_t rx_timestamp) {}
+static inline void bridge_stats_alloc_failed(void) {}
+static inline void bridge_stats_rx_queue_put(void) {}
+static inline void bridge_stats_rx_queue_get(void) {}
+static inline void bridge_stats_tx_queue_put(void) {}
+static inline void bridge_stats_tx_queue_get(void) {}
+static inline void bridge_stats_conn_interval_set(uint16_t interval) {}
+
+static inline uint32_t bridge_stats_timestamp(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_BT_NUS_BRIDGE_STATS */
+
+/** @} */
+
+#endif /* BRIDGE_STATS_H_ */
@@ -8,6 +8,8 @@
  *  @brief Nordic UART Bridge Service (NUS) sample
  */
 #include "uart_async_adapter.h"
+#include "bridge_stats.h"
+#include "uart_rx.h"
 
 #include <zephyr/types.h>
 #include <zephyr/kernel.h>
@@ -52,26 +54,29 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #define KEY_NUS_MODE 		DK_BTN3_MSK
 #define KEY_BEACON_MODE 	DK_BTN4_MSK
 
-#define UART_BUF_SIZE CONFIG_BT_NUS_UART_BUFFER_SIZE
-#define UART_WAIT_FOR_BUF_DELAY K_MSEC(50)
-#define UART_WAIT_FOR_RX CONFIG_BT_NUS_UART_RX_WAIT_TIME
 
 static K_SEM_DEFINE(ble_init_ok, 0, 1);
 
 static struct bt_conn *current_conn;
 static struct bt_conn *auth_conn;
 
+static struct bt_le_ext_adv *adv_set_nus;
+static struct bt_le_ext_adv *adv_set_beacon;
+static bool adv_nus_enabled = true;
+static bool adv_beacon_enabled = true;
+static struct k_work adv_nus_work;
+
 static const struct device *uart = DEVICE_DT_GET(DT_CHOSEN(nordic_nus_uart));
-static struct k_work_delayable uart_work;
 
-struct uart_data_t {
+/* UART TX fragment, sized to the data it carries */
+struct uart_tx_data_t {
 	void *fifo_reserved;
-	uint8_t data[UART_BUF_SIZE];
 	uint16_t len;
+	uint8_t data[];
 };
 
 static K_FIFO_DEFINE(fifo_uart_tx_data);
-static K_FIFO_DEFINE(fifo_uart_rx_data);
+static atomic_t uart_tx_busy;
 
 // NUS Advertising
 static const struct bt_data ad_nus[] = {
@@ -108,14 +113,51 @@ UART_ASYNC_ADAPTER_INST_DEFINE(async_adapter);
 static const struct device *const async_adapter;
 #endif
 
+/**
+ * @brief Start transmission of the next queued UART TX fragment
+ *
+ * Safe to call from any context. Does nothing while a transfer is in
+ * progress, the UART_TX_DONE handler picks up the queue in that case.
+ */
+static void uart_tx_next(void)
+{
+	struct uart_tx_data_t *buf;
+
+	while (atomic_cas(&uart_tx_busy, 0, 1)) {
+		buf = k_fifo_get(&fifo_uart_tx_data, K_NO_WAIT);
+		if (buf) {
+			bridge_stats_tx_queue_get();
+			if (!uart_tx(uart, buf->data, buf->len, SYS_FOREVER_MS)) {
+				return;
+			}
+
+			LOG_WRN("Failed to send data over UART");
+			k_free(buf);
+		}
+
+		atomic_clear(&uart_tx_busy);
+
+		/* Fragments queued while the flag was held would be left behind */
+		if (k_fifo_is_empty(&fifo_uart_tx_data)) {
+			return;
+		}
+	}
+}
+
+static void uart_tx_enqueue(struct uart_tx_data_t *buf)
+{
+	bridge_stats_tx_queue_put();
+	k_fifo_put(&fifo_uart_tx_data, buf);
+	uart_tx_next();
+}
+
 static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
 {
 	ARG_UNUSED(dev);
 
 	static size_t aborted_len;
-	struct uart_data_t *buf;
+	struct uart_tx_data_t *buf;
 	static uint8_t *aborted_buf;
-	static bool disable_req;
 
 	switch (evt->type) {
 	case UART_TX_DONE:
@@ -126,85 +168,19 @@ static void uart_cb(const struct device *dev, struct uart_event *evt, void *user
 		}
 
 		if (aborted_buf) {
-			buf = CONTAINER_OF(aborted_buf, struct uart_data_t,
+			buf = CONTAINER_OF(aborted_buf, struct uart_tx_data_t,
 					   data);
 			aborted_buf = NULL;
 			aborted_len = 0;
 		} else {
-			buf = CONTAINER_OF(evt->data.tx.buf, struct uart_data_t,
+			buf = CONTAINER_OF(evt->data.tx.buf, struct uart_tx_data_t,
 					   data);
 		}
 
 		k_free(buf);
 
-		buf = k_fifo_get(&fifo_uart_tx_data, K_NO_WAIT);
-		if (!buf) {
-			return;
-		}
-
-		if (uart_tx(uart, buf->data, buf->len, SYS_FOREVER_MS)) {
-			LOG_WRN("Failed to send data over UART");
-		}
-
-		break;
-
-	case UART_RX_RDY:
-		LOG_DBG("UART_RX_RDY");
-		buf = CONTAINER_OF(evt->data.rx.buf, struct uart_data_t, data);
-		buf->len += evt->data.rx.len;
-
-		if (disable_req) {
-			return;
-		}
-
-		if ((evt->data.rx.buf[buf->len - 1] == '\n') ||
-		    (evt->data.rx.buf[buf->len - 1] == '\r')) {
-			disable_req = true;
-			uart_rx_disable(uart);
-		}
-
-		break;
-
-	case UART_RX_DISABLED:
-		LOG_DBG("UART_RX_DISABLED");
-		disable_req = false;
-
-		buf = k_malloc(sizeof(*buf));
-		if (buf) {
-			buf->len = 0;
-		} else {
-			LOG_WRN("Not able to allocate UART receive buffer");
-			k_work_reschedule(&uart_work, UART_WAIT_FOR_BUF_DELAY);
-			return;
-		}
-
-		uart_rx_enable(uart, buf->data, sizeof(buf->data),
-			       UART_WAIT_FOR_RX);
-
-		break;
-
-	case UART_RX_BUF_REQUEST:
-		LOG_DBG("UART_RX_BUF_REQUEST");
-		buf = k_malloc(sizeof(*buf));
-		if (buf) {
-			buf->len = 0;
-			uart_rx_buf_rsp(uart, buf->data, sizeof(buf->data));
-		} else {
-			LOG_WRN("Not able to allocate UART receive buffer");
-		}
-
-		break;
-
-	case UART_RX_BUF_RELEASED:
-		LOG_DBG("UART_RX_BUF_RELEASED");
-		buf = CONTAINER_OF(evt->data.rx_buf.buf, struct uart_data_t,
-				   data);
-
-		if (buf->len > 0) {
-			k_fifo_put(&fifo_uart_rx_data, buf);
-		} else {
-			k_free(buf);
-		}
+		atomic_clear(&uart_tx_busy);
+		uart_tx_next();
 
 		break;
 
@@ -215,7 +191,7 @@ static void uart_cb(const struct device *dev, struct uart_event *evt, void *user
 		}
 
 		aborted_len += evt->data.tx.len;
-		buf = CONTAINER_OF(aborted_buf, struct uart_data_t,
+		buf = CONTAINER_OF(aborted_buf, struct uart_tx_data_t,
 				   data);
 
 		uart_tx(uart, &buf->data[aborted_len],
@@ -224,25 +200,28 @@ static void uart_cb(const struct device *dev, struct uart_event *evt, void *user
 		break;
 
 	default:
+		uart_rx_event(evt);
 		break;
 	}
 }
 
-static void uart_work_handler(struct k_work *item)
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+static void uart_adapter_stats_log(void)
 {
-	struct uart_data_t *buf;
+	struct uart_async_adapter_stats stats;
+	uint32_t bytes;
 
-	buf = k_malloc(sizeof(*buf));
-	if (buf) {
-		buf->len = 0;
-	} else {
-		LOG_WRN("Not able to allocate UART receive buffer");
-		k_work_reschedule(&uart_work, UART_WAIT_FOR_BUF_DELAY);
+	if ((uart != async_adapter) ||
+	    uart_async_adapter_stats_get(async_adapter, &stats)) {
 		return;
 	}
 
-	uart_rx_enable(uart, buf->data, sizeof(buf->data), UART_WAIT_FOR_RX);
+	bytes = stats.rx_bytes + stats.tx_bytes;
+	LOG_INF("Adapter: rx %u tx %u dropped %u, %u cycles/byte",
+		stats.rx_bytes, stats.tx_bytes, stats.rx_dropped,
+		bytes ? (uint32_t)(stats.isr_cycles / bytes) : 0);
 }
+#endif /* CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS */
 
 static bool uart_test_async_api(const struct device *dev)
 {
@@ -255,9 +234,8 @@ static bool uart_test_async_api(const struct device *dev)
 static int uart_init(void)
 {
 	int err;
-	int pos;
-	struct uart_data_t *rx;
-	struct uart_data_t *tx;
+	struct uart_tx_data_t *tx;
+	static const char welcome[] = "Starting Nordic UART service example\r\n";
 
 	if (!device_is_ready(uart)) {
 		return -ENODEV;
@@ -271,16 +249,6 @@ static int uart_init(void)
 		}
 	}
 
-	rx = k_malloc(sizeof(*rx));
-	if (rx) {
-		rx->len = 0;
-	} else {
-		return -ENOMEM;
-	}
-
-	k_work_init_delayable(&uart_work, uart_work_handler);
-
-
 	if (IS_ENABLED(CONFIG_BT_NUS_UART_ASYNC_ADAPTER) && !uart_test_async_api(uart)) {
 		/* Implement API adapter */
 		uart_async_adapter_init(async_adapter, uart);
@@ -289,7 +257,6 @@ static int uart_init(void)
 
 	err = uart_callback_set(uart, uart_cb, NULL);
 	if (err) {
-		k_free(rx);
 		LOG_ERR("Cannot initialize UART callback");
 		return err;
 	}
@@ -317,43 +284,111 @@ static int uart_init(void)
 		}
 	}
 
-	tx = k_malloc(sizeof(*tx));
+	tx = k_malloc(sizeof(*tx) + sizeof(welcome));
 
 	if (tx) {
-		pos = snprintf(tx->data, sizeof(tx->data),
-			       "Starting Nordic UART service example\r\n");
-
-		if ((pos < 0) || (pos >= sizeof(tx->data))) {
-			k_free(rx);
-			k_free(tx);
-			LOG_ERR("snprintf returned %d", pos);
-			return -ENOMEM;
-		}
-
-		tx->len = pos;
+		tx->len = sizeof(welcome) - 1;
+		memcpy(tx->data, welcome, tx->len);
 	} else {
-		k_free(rx);
 		return -ENOMEM;
 	}
 
-	err = uart_tx(uart, tx->data, tx->len, SYS_FOREVER_MS);
+	/* The tx buffer is handled in the callback from now on */
+	uart_tx_enqueue(tx);
+
+	err = uart_rx_start(uart);
+	if (err) {
+		LOG_ERR("Cannot enable uart reception (err: %d)", err);
+	}
+
+	return err;
+}
+
+static int adv_create_nus(void)
+{
+	int err;
+	struct bt_le_adv_param param =
+		BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_CONNECTABLE,
+				     CONFIG_BT_NUS_ADV_NUS_INTERVAL,
+				     CONFIG_BT_NUS_ADV_NUS_INTERVAL,
+				     NULL);
+
+	err = bt_le_ext_adv_create(&param, NULL, &adv_set_nus);
+	if (err) {
+		LOG_ERR("Failed to create NUS advertising set (err %d)", err);
+		return err;
+	}
+
+	err = bt_le_ext_adv_set_data(adv_set_nus, ad_nus, ARRAY_SIZE(ad_nus),
+				     sd_nus, ARRAY_SIZE(sd_nus));
 	if (err) {
-		k_free(rx);
-		k_free(tx);
-		LOG_ERR("Cannot display welcome message (err: %d)", err);
+		LOG_ERR("Failed to set NUS advertising data (err %d)", err);
+	}
+
+	return err;
+}
+
+static int adv_create_beacon(void)
+{
+	int err;
+	struct bt_le_adv_param param =
+		BT_LE_ADV_PARAM_INIT(BT_LE_ADV_OPT_SCANNABLE |
+				     BT_LE_ADV_OPT_USE_IDENTITY,
+				     CONFIG_BT_NUS_ADV_BEACON_INTERVAL,
+				     CONFIG_BT_NUS_ADV_BEACON_INTERVAL,
+				     NULL);
+
+	err = bt_le_ext_adv_create(&param, NULL, &adv_set_beacon);
+	if (err) {
+		LOG_ERR("Failed to create Beacon advertising set (err %d)", err);
 		return err;
 	}
 
-	err = uart_rx_enable(uart, rx->data, sizeof(rx->data), 50);
+	err = bt_le_ext_adv_set_data(adv_set_beacon, ad_beacon, ARRAY_SIZE(ad_beacon),
+				     sd_beacon, ARRAY_SIZE(sd_beacon));
 	if (err) {
-		LOG_ERR("Cannot enable uart reception (err: %d)", err);
-		/* Free the rx buffer only because the tx buffer will be handled in the callback */
-		k_free(rx);
+		LOG_ERR("Failed to set Beacon advertising data (err %d)", err);
 	}
 
 	return err;
 }
 
+/**
+ * @brief Start or stop one advertising set
+ *
+ * Each role has its own set, so changing one of them never interrupts
+ * the advertising of the other.
+ */
+static void adv_set_enable(struct bt_le_ext_adv *adv, bool enable, const char *name)
+{
+	int err;
+
+	if (!adv) {
+		/* Bluetooth is not initialized yet */
+		return;
+	}
+
+	if (enable) {
+		LOG_INF("Starting %s Advertisement", name);
+		err = bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT);
+	} else {
+		LOG_INF("Stopping %s Advertisement", name);
+		err = bt_le_ext_adv_stop(adv);
+	}
+
+	if (err) {
+		LOG_ERR("%s advertising failed to %s (err %d)", name,
+			enable ? "start" : "stop", err);
+	}
+}
+
+static void adv_nus_work_handler(struct k_work *item)
+{
+	if (adv_nus_enabled) {
+		adv_set_enable(adv_set_nus, true, "NUS Service");
+	}
+}
+
 static void connected(struct bt_conn *conn, uint8_t err)
 {
 	char addr[BT_ADDR_LE_STR_LEN];
@@ -368,6 +403,14 @@ static void connected(struct bt_conn *conn, uint8_t err)
 
 	current_conn = bt_conn_ref(conn);
 
+	if (IS_ENABLED(CONFIG_BT_NUS_BRIDGE_STATS)) {
+		struct bt_conn_info info;
+
+		if (!bt_conn_get_info(conn, &info)) {
+			bridge_stats_conn_interval_set(info.le.interval);
+		}
+	}
+
 	dk_set_led_on(CON_STATUS_LED);
 }
 
@@ -388,9 +431,19 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
 		bt_conn_unref(current_conn);
 		current_conn = NULL;
 		dk_set_led_off(CON_STATUS_LED);
+		bridge_stats_conn_interval_set(0);
 	}
 }
 
+/* The connection object is only free for a new connection once recycled,
+ * restarting the connectable set before that fails with one connection.
+ */
+static void recycled(void)
+{
+	/* The connectable set stopped when the connection was established */
+	k_work_submit(&adv_nus_work);
+}
+
 #ifdef CONFIG_BT_NUS_SECURITY_ENABLED
 static void security_changed(struct bt_conn *conn, bt_security_t level,
 			     enum bt_security_err err)
@@ -408,9 +461,21 @@ static void security_changed(struct bt_conn *conn, bt_security_t level,
 }
 #endif
 
+static void le_param_updated(struct bt_conn *conn, uint16_t interval,
+			     uint16_t latency, uint16_t timeout)
+{
+	LOG_DBG("Connection interval updated: %u", interval);
+
+	if (conn == current_conn) {
+		bridge_stats_conn_interval_set(interval);
+	}
+}
+
 BT_CONN_CB_DEFINE(conn_callbacks) = {
 	.connected    = connected,
 	.disconnected = disconnected,
+	.recycled     = recycled,
+	.le_param_updated = le_param_updated,
 #ifdef CONFIG_BT_NUS_SECURITY_ENABLED
 	.security_changed = security_changed,
 #endif
@@ -487,47 +552,40 @@ static struct bt_conn_auth_info_cb conn_auth_info_callbacks;
 static void bt_receive_cb(struct bt_conn *conn, const uint8_t *const data,
 			  uint16_t len)
 {
-	int err;
 	char addr[BT_ADDR_LE_STR_LEN] = {0};
 
 	bt_addr_le_to_str(bt_conn_get_dst(conn), addr, ARRAY_SIZE(addr));
 
 	LOG_INF("Received data from: %s", addr);
 
-	for (uint16_t pos = 0; pos != len;) {
-		struct uart_data_t *tx = k_malloc(sizeof(*tx));
-
-		if (!tx) {
-			LOG_WRN("Not able to allocate UART send data buffer");
-			return;
-		}
-
-		/* Keep the last byte of TX buffer for potential LF char. */
-		size_t tx_data_size = sizeof(tx->data) - 1;
-
-		if ((len - pos) > tx_data_size) {
-			tx->len = tx_data_size;
-		} else {
-			tx->len = (len - pos);
-		}
+	if (!len) {
+		return;
+	}
 
-		memcpy(tx->data, &data[pos], tx->len);
+	/* The ATT buffer is only valid during this callback, so the whole
+	 * write goes into one fragment that the UART DMA sends from directly.
+	 * Keep one extra byte for a potential LF char.
+	 */
+	struct uart_tx_data_t *tx = k_malloc(sizeof(*tx) + len + 1);
 
-		pos += tx->len;
+	if (!tx) {
+		bridge_stats_alloc_failed();
+		LOG_WRN("Not able to allocate UART send data buffer");
+		return;
+	}
 
-		/* Append the LF character when the CR character triggered
-		 * transmission from the peer.
-		 */
-		if ((pos == len) && (data[len - 1] == '\r')) {
-			tx->data[tx->len] = '\n';
-			tx->len++;
-		}
+	memcpy(tx->data, data, len);
+	tx->len = len;
 
-		err = uart_tx(uart, tx->data, tx->len, SYS_FOREVER_MS);
-		if (err) {
-			k_fifo_put(&fifo_uart_tx_data, tx);
-		}
+	/* Append the LF character when the CR character triggered
+	 * transmission from the peer.
+	 */
+	if (data[len - 1] == '\r') {
+		tx->data[tx->len] = '\n';
+		tx->len++;
 	}
+
+	uart_tx_enqueue(tx);
 }
 
 static struct bt_nus_cb nus_cb = {
@@ -558,36 +616,28 @@ static void num_comp_reply(bool accept)
 	bt_conn_unref(auth_conn);
 	auth_conn = NULL;
 }
+#endif /* CONFIG_BT_NUS_SECURITY_ENABLED */
 
 void button_changed(uint32_t button_state, uint32_t has_changed)
 {
 	uint32_t buttons = button_state & has_changed;
-	int err;
 
 	if (buttons & KEY_NUS_MODE) {
-		LOG_INF("Stopping Advertisement");
-		bt_le_adv_stop();
-		LOG_INF("Starting NUS Service Advertisement");
-		err = bt_le_adv_start(BT_LE_ADV_CONN, ad_nus, ARRAY_SIZE(ad_nus), sd_nus,
-							ARRAY_SIZE(sd_nus));
-		if (err) {
-			LOG_ERR("Advertising failed to start (err %d)", err);
-			return;
+		adv_nus_enabled = !adv_nus_enabled;
+		if (adv_nus_enabled && current_conn) {
+			/* Only one connection, the set restarts on disconnection */
+			LOG_INF("NUS Service Advertisement resumes after disconnection");
+		} else {
+			adv_set_enable(adv_set_nus, adv_nus_enabled, "NUS Service");
 		}
 	}
 
 	if (buttons & KEY_BEACON_MODE) {
-		LOG_INF("Stopping Advertisement");
-		bt_le_adv_stop();
-		LOG_INF("Starting Beacon Service Advertisement");
-		err = bt_le_adv_start(BT_LE_ADV_NCONN_IDENTITY, ad_beacon, ARRAY_SIZE(ad_beacon), sd_beacon,
-							ARRAY_SIZE(sd_beacon));
-		if (err) {
-			LOG_ERR("Advertising failed to start (err %d)", err);
-			return;
-		}
+		adv_beacon_enabled = !adv_beacon_enabled;
+		adv_set_enable(adv_set_beacon, adv_beacon_enabled, "Beacon Service");
 	}
 
+#ifdef CONFIG_BT_NUS_SECURITY_ENABLED
 	if (auth_conn) {
 		if (buttons & KEY_PASSKEY_ACCEPT) {
 			num_comp_reply(true);
@@ -597,19 +647,17 @@ void button_changed(uint32_t button_state, uint32_t has_changed)
 			num_comp_reply(false);
 		}
 	}
-}
 #endif /* CONFIG_BT_NUS_SECURITY_ENABLED */
+}
 
 static void configure_gpio(void)
 {
 	int err;
 
-//#ifdef CONFIG_BT_NUS_SECURITY_ENABLED
 	err = dk_buttons_init(button_changed);
 	if (err) {
 		LOG_ERR("Cannot init buttons (err: %d)", err);
 	}
-//#endif /* CONFIG_BT_NUS_SECURITY_ENABLED */
 
 	err = dk_leds_init();
 	if (err) {
@@ -662,20 +710,109 @@ int main(void)
 		return 0;
 	}
 
-	LOG_INF("Starting NUS Service Advertisement");
-	err = bt_le_adv_start(BT_LE_ADV_CONN, ad_nus, ARRAY_SIZE(ad_nus), sd_nus,
-			      ARRAY_SIZE(sd_nus));
+	k_work_init(&adv_nus_work, adv_nus_work_handler);
+
+	err = adv_create_nus();
 	if (err) {
-		LOG_ERR("Advertising failed to start (err %d)", err);
 		return 0;
 	}
 
+	err = adv_create_beacon();
+	if (err) {
+		return 0;
+	}
+
+	adv_set_enable(adv_set_nus, adv_nus_enabled, "NUS Service");
+	adv_set_enable(adv_set_beacon, adv_beacon_enabled, "Beacon Service");
+
 	for (;;) {
 		dk_set_led(RUN_STATUS_LED, (++blink_status) % 2);
 		k_sleep(K_MSEC(RUN_LED_BLINK_INTERVAL));
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+		if ((blink_status % 10) == 0) {
+			uart_adapter_stats_log();
+		}
+#endif
 	}
 }
 
+#if CONFIG_BT_NUS_UART_LINE_FRAMING
+/* Received chunk that still holds bytes past the end of the last line */
+static struct uart_data_t *line_pending;
+
+/**
+ * @brief Move received bytes into the line being assembled
+ *
+ * Bytes are copied up to and including the first CR or LF. Whatever is
+ * left in @p rx is kept for the next line.
+ *
+ * @param line Line being assembled
+ * @param rx   Chunk received from UART, consumed by this function
+ * @return true if the line is complete and should be sent
+ */
+static bool line_fill(struct uart_data_t *line, struct uart_data_t *rx)
+{
+	bool eol = false;
+	size_t n = 0;
+
+	if (!line->len) {
+		line->timestamp = rx->timestamp;
+	}
+
+	while ((n < rx->len) && (line->len < sizeof(line->data))) {
+		uint8_t c = rx->data[n++];
+
+		line->data[line->len++] = c;
+		if ((c == '\n') || (c == '\r')) {
+			eol = true;
+			break;
+		}
+	}
+
+	if (n < rx->len) {
+		memmove(rx->data, &rx->data[n], rx->len - n);
+		rx->len -= n;
+		line_pending = rx;
+	} else {
+		uart_rx_free(rx);
+	}
+
+	return eol || (line->len == sizeof(line->data));
+}
+
+void ble_write_thread(void)
+{
+	static struct uart_data_t line;
+
+	/* Don't go any further until BLE is initialized */
+	k_sem_take(&ble_init_ok, K_FOREVER);
+
+	for (;;) {
+		struct uart_data_t *buf = line_pending;
+
+		if (buf) {
+			line_pending = NULL;
+		} else {
+			/* Wait indefinitely for the first byte of a line */
+			buf = uart_rx_get(line.len ?
+					  K_MSEC(CONFIG_BT_NUS_UART_LINE_TIMEOUT) :
+					  K_FOREVER);
+		}
+
+		if (buf && !line_fill(&line, buf)) {
+			continue;
+		}
+
+		if (bt_nus_send(NULL, line.data, line.len)) {
+			LOG_WRN("Failed to send data over BLE connection");
+		} else {
+			bridge_stats_ble_tx(line.len, line.timestamp);
+		}
+
+		line.len = 0;
+	}
+}
+#else
 void ble_write_thread(void)
 {
 	/* Don't go any further until BLE is initialized */
@@ -683,16 +820,18 @@ void ble_write_thread(void)
 
 	for (;;) {
 		/* Wait indefinitely for data to be sent over bluetooth */
-		struct uart_data_t *buf = k_fifo_get(&fifo_uart_rx_data,
-						     K_FOREVER);
+		struct uart_data_t *buf = uart_rx_get(K_FOREVER);
 
 		if (bt_nus_send(NULL, buf->data, buf->len)) {
 			LOG_WRN("Failed to send data over BLE connection");
+		} else {
+			bridge_stats_ble_tx(buf->len, buf->timestamp);
 		}
 
-		k_free(buf);
+		uart_rx_free(buf);
 	}
 }
+#endif /* CONFIG_BT_NUS_UART_LINE_FRAMING */
 
 K_THREAD_DEFINE(ble_write_thread_id, STACKSIZE, ble_write_thread, NULL, NULL,
 		NULL, PRIORITY, 0, 0);
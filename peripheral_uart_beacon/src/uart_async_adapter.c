@@ -23,6 +23,16 @@ LOG_MODULE_REGISTER(uart_async_adapter);
 #error "The adapter requires UART INTERRUPT API to be enabled"
 #endif
 
+#define RX_RING_ENABLED (CONFIG_BT_NUS_UART_ASYNC_ADAPTER_RX_RING_SIZE > 0)
+
+/* Size of the chunk used to drain the FIFO when data has to be dropped */
+#define RX_DROP_CHUNK_SIZE 16
+
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+#define STATS_ADD(_data, _field, _val) ((_data)->stats._field += (_val))
+#else
+#define STATS_ADD(_data, _field, _val)
+#endif
 
 /**
  * @brief Access the data inside device
@@ -224,6 +234,10 @@ static int rx_enable(const struct device *dev, uint8_t *buf, size_t len, int32_t
 	data->rx.next_buf_len = len;
 	data->rx.timeout = timeout;
 	data->rx.enabled = true;
+#if RX_RING_ENABLED
+	/* Nothing from an earlier session goes into the new buffers */
+	ring_buf_reset(&data->rx.ring);
+#endif
 
 	k_spin_unlock(&(data->lock), key);
 
@@ -261,6 +275,15 @@ static int rx_disable(const struct device *dev)
 	data->rx.enabled = false;
 	uart_irq_rx_disable(data->target);
 	uart_irq_err_disable(data->target);
+
+#if RX_RING_ENABLED
+	k_spinlock_key_t key = k_spin_lock(&(data->lock));
+
+	/* Data not delivered yet belongs to the session that ends here */
+	ring_buf_reset(&data->rx.ring);
+	k_spin_unlock(&(data->lock), key);
+#endif
+
 	while (data->rx.buf) {
 		switch_rx_buffer(dev, false);
 	}
@@ -379,21 +402,38 @@ static int drv_cmd(const struct device *dev, uint32_t cmd, uint32_t p)
 
 static inline void on_tx_ready(const struct device *dev, struct uart_async_adapter_data *data)
 {
+	const uint8_t *curr_buf;
+	size_t size_left;
+	int ret;
+
 	k_spinlock_key_t key = k_spin_lock(&(data->lock));
 
-	LOG_DBG("%s: Enter(%s) (left: %u)", __func__, dev->name, data->tx.size_left);
-	if (data->tx.size_left) {
-		__ASSERT_NO_MSG(data->tx.curr_buf);
-		int ret;
+	curr_buf = data->tx.curr_buf;
+	size_left = data->tx.size_left;
 
-		ret = uart_fifo_fill(data->target, data->tx.curr_buf, data->tx.size_left);
-		LOG_DBG("Pushed %d characters", ret);
-		if (ret <= 0) {
-			LOG_ERR("Unexpected fifo fill err: %d", ret);
-		} else {
-			data->tx.curr_buf += ret;
-			data->tx.size_left -= ret;
-		}
+	k_spin_unlock(&(data->lock), key);
+
+	LOG_DBG("%s: Enter(%s) (left: %u)", __func__, dev->name, size_left);
+	if (!size_left) {
+		return;
+	}
+
+	__ASSERT_NO_MSG(curr_buf);
+	/* Fill as much of the FIFO as possible in one go, without the lock */
+	ret = uart_fifo_fill(data->target, curr_buf, size_left);
+	LOG_DBG("Pushed %d characters", ret);
+	if (ret <= 0) {
+		LOG_ERR("Unexpected fifo fill err: %d", ret);
+		return;
+	}
+
+	key = k_spin_lock(&(data->lock));
+
+	/* The transfer might have been aborted in the meantime */
+	if (data->tx.curr_buf == curr_buf) {
+		data->tx.curr_buf += ret;
+		data->tx.size_left -= ret;
+		STATS_ADD(data, tx_bytes, ret);
 	}
 
 	k_spin_unlock(&(data->lock), key);
@@ -437,61 +477,149 @@ static inline void on_tx_complete(const struct device *dev, struct uart_async_ad
 	LOG_DBG("%s: Exit", __func__);
 }
 
+/**
+ * @brief Make sure there is room in the current RX buffer
+ *
+ * Switches to the next user buffer when the current one is full.
+ * A new buffer is requested from the user only if there was a buffer to
+ * switch from or to, so a missing buffer is not requested on every call.
+ *
+ * @param dev  Adapter device
+ * @param data Adapter data
+ * @return Number of bytes that can be written to the current buffer
+ */
+static size_t rx_buf_ensure(const struct device *dev, struct uart_async_adapter_data *data)
+{
+	if (!data->rx.size_left && (data->rx.buf || data->rx.next_buf)) {
+		notify_rx_buffer(dev);
+		switch_rx_buffer(dev, true);
+	}
+
+	return data->rx.size_left;
+}
+
+/**
+ * @brief Mark data written directly into the current RX buffer as received
+ *
+ * @param data Adapter data
+ * @param len  Number of bytes written at the current position
+ */
+static inline void rx_buf_commit(struct uart_async_adapter_data *data, size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&(data->lock));
+
+	__ASSERT_NO_MSG(data->rx.size_left >= len);
+	data->rx.curr_buf += len;
+	data->rx.size_left -= len;
+
+	k_spin_unlock(&(data->lock), key);
+}
+
+#if RX_RING_ENABLED
+/**
+ * @brief Move data held in the software ring into user buffers
+ *
+ * @param dev  Adapter device
+ * @param data Adapter data
+ * @return true if the ring is empty
+ */
+static bool rx_ring_flush(const struct device *dev, struct uart_async_adapter_data *data)
+{
+	while (!ring_buf_is_empty(&data->rx.ring)) {
+		size_t room = rx_buf_ensure(dev, data);
+
+		if (!room) {
+			return false;
+		}
+
+		rx_buf_commit(data, ring_buf_get(&data->rx.ring, data->rx.curr_buf, room));
+	}
+
+	return true;
+}
+#endif /* RX_RING_ENABLED */
+
+/**
+ * @brief Read FIFO data that has no user buffer to go into
+ *
+ * The data is stored in the software ring if enabled, otherwise it is
+ * dropped in chunks.
+ *
+ * @param data    Adapter data
+ * @param dropped Incremented by the number of bytes dropped
+ * @return Number of bytes read from the FIFO
+ */
+static int rx_overflow_read(struct uart_async_adapter_data *data, size_t *dropped)
+{
+	uint8_t dummy[RX_DROP_CHUNK_SIZE];
+	int ret;
+
+#if RX_RING_ENABLED
+	uint8_t *dst;
+	uint32_t room = ring_buf_put_claim(&data->rx.ring, &dst, UINT32_MAX);
+
+	if (room) {
+		ret = uart_fifo_read(data->target, dst, room);
+		ring_buf_put_finish(&data->rx.ring, MAX(ret, 0));
+		return ret;
+	}
+#endif
+
+	ret = uart_fifo_read(data->target, dummy, sizeof(dummy));
+	if (ret > 0) {
+		*dropped += ret;
+		STATS_ADD(data, rx_dropped, ret);
+	}
+
+	return ret;
+}
+
 static inline void on_rx_ready(const struct device *dev, struct uart_async_adapter_data *data)
 {
 	int ret;
-	bool notify_now = false;
+	size_t room;
+	size_t dropped = 0;
+	bool buffered = false;
 
 	LOG_DBG("%s: Enter (%s)", __func__, dev->name);
 	if (data->rx.timeout != SYS_FOREVER_MS) {
 		k_timer_start(&data->rx.timeout_timer, SYS_TIMEOUT_MS(data->rx.timeout), K_NO_WAIT);
 	}
-	do {
-		k_spinlock_key_t key = k_spin_lock(&(data->lock));
-
-		if (!data->rx.size_left) {
-			notify_now = false;
-
-			k_spin_unlock(&(data->lock), key);
 
-			notify_rx_buffer(dev);
-			switch_rx_buffer(dev, true);
+#if RX_RING_ENABLED
+	/* Data absorbed by the ring earlier has to go out first */
+	buffered = !rx_ring_flush(dev, data);
+#endif
 
-			key = k_spin_lock(&(data->lock));
-		}
-		if (!data->rx.size_left) {
-			/* Data received without buffer - dropping */
-			uint8_t dummy;
-			size_t cnt = 0;
-
-			do {
-				ret = uart_fifo_read(data->target, &dummy, 1);
-				if (ret < 0) {
-					LOG_ERR("Unexpected error on FIFO dropping: %d", ret);
-					ret = 0;
-				}
-				cnt += ret;
-			} while (ret);
-			LOG_ERR("Data received without buffer prepared, dropped %d bytes", cnt);
+	do {
+		room = buffered ? 0 : rx_buf_ensure(dev, data);
+
+		if (!room) {
+			/* Data received without buffer, keep the ring in front
+			 * of any buffer that shows up until it is flushed.
+			 */
+			ret = rx_overflow_read(data, &dropped);
+			buffered = RX_RING_ENABLED;
 		} else {
-			ret = uart_fifo_read(data->target, data->rx.curr_buf, data->rx.size_left);
-			LOG_DBG("Received %d characters", ret);
-			if (ret < 0) {
-				LOG_ERR("Unexpected error on FIFO read: %d", ret);
-				ret = 0;
-			}
-			__ASSERT_NO_MSG(data->rx.size_left >= ret);
-			data->rx.curr_buf += ret;
-			data->rx.size_left -= ret;
-			if (data->rx.timeout == 0) {
-				notify_now = true;
+			/* Read straight into the user buffer, as much as fits */
+			ret = uart_fifo_read(data->target, data->rx.curr_buf, room);
+			if (ret > 0) {
+				rx_buf_commit(data, ret);
 			}
 		}
+		LOG_DBG("Received %d characters", ret);
 
-		k_spin_unlock(&(data->lock), key);
-
+		if (ret < 0) {
+			LOG_ERR("Unexpected error on FIFO read: %d", ret);
+			ret = 0;
+		}
+		STATS_ADD(data, rx_bytes, ret);
 	} while (ret);
-	if (notify_now) {
+
+	if (dropped) {
+		LOG_ERR("Data received without buffer prepared, dropped %d bytes", dropped);
+	}
+	if (data->rx.timeout == 0) {
 		notify_rx_buffer(dev);
 	}
 	LOG_DBG("%s: Exit", __func__);
@@ -519,6 +647,9 @@ static void uart_irq_handler(const struct device *target_dev, void *context)
 
 	__ASSERT(target_dev == data->target,
 		"IRQ handler called with a context that seems uninitialized.");
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+	uint32_t start = k_cycle_get_32();
+#endif
 	LOG_DBG("irq_handler: Enter");
 	if (uart_irq_update(target_dev) && uart_irq_is_pending(target_dev)) {
 		if (data->tx.enabled && uart_irq_tx_ready(target_dev)) {
@@ -541,6 +672,10 @@ static void uart_irq_handler(const struct device *target_dev, void *context)
 			on_error(dev, data, rx_err);
 		}
 	}
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+	data->stats.isr_cycles += k_cycle_get_32() - start;
+	data->stats.isr_count++;
+#endif
 	LOG_DBG("irq_handler: Exit");
 }
 
@@ -581,8 +716,21 @@ static void tx_timeout(struct k_timer *timer)
 static void rx_timeout(struct k_timer *timer)
 {
 	const struct device *dev = k_timer_user_data_get(timer);
+	/* The ring, the buffer switch and the notification are shared with
+	 * uart_irq_handler(), which must not run in between. Masking only
+	 * the RX interrupt would still let TX and error handling in, and
+	 * data->lock cannot be held across the user callbacks.
+	 */
+	unsigned int key = irq_lock();
+
+#if RX_RING_ENABLED
+	/* The line is idle, hand over data still held in the ring */
+	(void)rx_ring_flush(dev, access_dev_data(dev));
+#endif
 
 	notify_rx_buffer(dev);
+
+	irq_unlock(key);
 }
 
 void uart_async_adapter_init(const struct device *dev, const struct device *target)
@@ -602,5 +750,30 @@ void uart_async_adapter_init(const struct device *dev, const struct device *targ
 	k_timer_init(&data->rx.timeout_timer, rx_timeout, NULL);
 	k_timer_user_data_set(&data->rx.timeout_timer, (void *)dev);
 
+#if RX_RING_ENABLED
+	ring_buf_init(&data->rx.ring, sizeof(data->rx.ring_mem), data->rx.ring_mem);
+#endif
+
 	dev->state->initialized = true;
 }
+
+int uart_async_adapter_stats_get(const struct device *dev,
+				 struct uart_async_adapter_stats *stats)
+{
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+	struct uart_async_adapter_data *data = access_dev_data(dev);
+
+	k_spinlock_key_t key = k_spin_lock(&(data->lock));
+
+	*stats = data->stats;
+
+	k_spin_unlock(&(data->lock), key);
+
+	return 0;
+#else
+	ARG_UNUSED(dev);
+	ARG_UNUSED(stats);
+
+	return -ENOTSUP;
+#endif
+}
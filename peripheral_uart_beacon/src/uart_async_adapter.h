@@ -22,7 +22,25 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/ring_buffer.h>
 
+/**
+ * @brief UART async adapter statistics
+ *
+ * Collected when CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS is enabled.
+ */
+struct uart_async_adapter_stats {
+	/** Bytes read from the target FIFO */
+	uint32_t rx_bytes;
+	/** Bytes written to the target FIFO */
+	uint32_t tx_bytes;
+	/** Bytes dropped because no buffer or ring space was available */
+	uint32_t rx_dropped;
+	/** CPU cycles spent in the target interrupt handler */
+	uint64_t isr_cycles;
+	/** Number of target interrupts handled */
+	uint32_t isr_count;
+};
 
 /**
  * @brief UART asynch adapter data structure
@@ -75,7 +93,18 @@ struct uart_async_adapter_data {
 		struct k_timer timeout_timer;
 		/** RX state */
 		bool enabled;
+#if CONFIG_BT_NUS_UART_ASYNC_ADAPTER_RX_RING_SIZE > 0
+		/** Ring holding data received while no buffer is available */
+		struct ring_buf ring;
+		/** Storage of the ring */
+		uint8_t ring_mem[CONFIG_BT_NUS_UART_ASYNC_ADAPTER_RX_RING_SIZE];
+#endif
 	} rx;
+
+#ifdef CONFIG_BT_NUS_UART_ASYNC_ADAPTER_STATS
+	/** Adapter statistics */
+	struct uart_async_adapter_stats stats;
+#endif
 };
 
 /**
@@ -123,4 +152,16 @@ extern const struct uart_driver_api uart_async_adapter_driver_api;
  */
 void uart_async_adapter_init(const struct device *dev, const struct device *target);
 
+/**
+ * @brief Get adapter statistics
+ *
+ * @param dev   The adapter interface
+ * @param stats Structure to store the statistics in
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if statistics are not enabled
+ */
+int uart_async_adapter_stats_get(const struct device *dev,
+				 struct uart_async_adapter_stats *stats);
+
 /** @} */
@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file
+ *  @brief Continuous UART reception towards the NUS bridge
+ */
+#include "uart_rx.h"
+#include "bridge_stats.h"
+
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(uart_rx);
+
+#define UART_BUF_SIZE CONFIG_BT_NUS_UART_BUFFER_SIZE
+#define UART_WAIT_FOR_BUF_DELAY K_MSEC(50)
+#define UART_WAIT_FOR_RX CONFIG_BT_NUS_UART_RX_WAIT_TIME
+#define UART_RX_BUF_SIZE CONFIG_BT_NUS_UART_RX_BUF_SIZE
+#define UART_RX_BUF_COUNT CONFIG_BT_NUS_UART_RX_BUF_COUNT
+#define UART_RX_DATA_COUNT CONFIG_BT_NUS_UART_RX_DATA_COUNT
+
+BUILD_ASSERT(UART_RX_DATA_COUNT >=
+	     UART_RX_BUF_COUNT * DIV_ROUND_UP(UART_RX_BUF_SIZE, UART_BUF_SIZE),
+	     "The chunk pool cannot take the data held by the DMA buffers");
+
+/* DMA buffers cycled by the UART while reception is running. */
+K_MEM_SLAB_DEFINE_STATIC(uart_rx_slab, UART_RX_BUF_SIZE, UART_RX_BUF_COUNT, 4);
+
+/* Received chunks waiting for BLE. A fixed pool keeps a burst from
+ * exhausting the heap that the UART TX path allocates from.
+ */
+K_MEM_SLAB_DEFINE_STATIC(uart_rx_data_slab, sizeof(struct uart_data_t), UART_RX_DATA_COUNT, 4);
+
+static K_FIFO_DEFINE(fifo_uart_rx_data);
+
+static const struct device *uart;
+static struct k_work_delayable uart_work;
+
+static void uart_rx_forward(const uint8_t *data, size_t len)
+{
+	struct uart_data_t *buf;
+	uint32_t timestamp = bridge_stats_timestamp();
+
+	bridge_stats_uart_rx(len);
+
+	for (size_t pos = 0; pos != len;) {
+		if (k_mem_slab_alloc(&uart_rx_data_slab, (void **)&buf, K_NO_WAIT)) {
+			bridge_stats_alloc_failed();
+			LOG_WRN("Not able to allocate UART receive buffer, "
+				"dropped %u bytes", len - pos);
+			return;
+		}
+
+		buf->len = MIN(len - pos, sizeof(buf->data));
+		buf->timestamp = timestamp;
+		memcpy(buf->data, &data[pos], buf->len);
+		pos += buf->len;
+
+		bridge_stats_rx_queue_put();
+		k_fifo_put(&fifo_uart_rx_data, buf);
+	}
+}
+
+static void uart_work_handler(struct k_work *item)
+{
+	uint8_t *buf;
+
+	if (k_mem_slab_alloc(&uart_rx_slab, (void **)&buf, K_NO_WAIT)) {
+		LOG_WRN("Not able to allocate UART receive buffer");
+		k_work_reschedule(&uart_work, UART_WAIT_FOR_BUF_DELAY);
+		return;
+	}
+
+	uart_rx_enable(uart, buf, UART_RX_BUF_SIZE, UART_WAIT_FOR_RX);
+}
+
+int uart_rx_start(const struct device *dev)
+{
+	int err;
+	uint8_t *rx;
+
+	uart = dev;
+	k_work_init_delayable(&uart_work, uart_work_handler);
+
+	if (k_mem_slab_alloc(&uart_rx_slab, (void **)&rx, K_NO_WAIT)) {
+		return -ENOMEM;
+	}
+
+	err = uart_rx_enable(uart, rx, UART_RX_BUF_SIZE, UART_WAIT_FOR_RX);
+	if (err) {
+		k_mem_slab_free(&uart_rx_slab, rx);
+	}
+
+	return err;
+}
+
+void uart_rx_event(struct uart_event *evt)
+{
+	uint8_t *rx_buf;
+
+	switch (evt->type) {
+	case UART_RX_RDY:
+		LOG_DBG("UART_RX_RDY");
+		/* Reception keeps running into the same DMA buffer, so only
+		 * the newly received part is forwarded.
+		 */
+		uart_rx_forward(&evt->data.rx.buf[evt->data.rx.offset],
+				evt->data.rx.len);
+
+		break;
+
+	case UART_RX_DISABLED:
+		LOG_DBG("UART_RX_DISABLED");
+		/* Reception is only stopped by the driver on errors */
+		k_work_reschedule(&uart_work, K_NO_WAIT);
+
+		break;
+
+	case UART_RX_BUF_REQUEST:
+		LOG_DBG("UART_RX_BUF_REQUEST");
+		if (!k_mem_slab_alloc(&uart_rx_slab, (void **)&rx_buf, K_NO_WAIT)) {
+			uart_rx_buf_rsp(uart, rx_buf, UART_RX_BUF_SIZE);
+		} else {
+			bridge_stats_alloc_failed();
+			LOG_WRN("Not able to allocate UART receive buffer");
+		}
+
+		break;
+
+	case UART_RX_BUF_RELEASED:
+		LOG_DBG("UART_RX_BUF_RELEASED");
+		k_mem_slab_free(&uart_rx_slab, evt->data.rx_buf.buf);
+
+		break;
+
+	case UART_RX_STOPPED:
+		LOG_WRN("UART_RX_STOPPED (reason %d)", evt->data.rx_stop.reason);
+
+		break;
+
+	default:
+		break;
+	}
+}
+
+struct uart_data_t *uart_rx_get(k_timeout_t timeout)
+{
+	struct uart_data_t *buf = k_fifo_get(&fifo_uart_rx_data, timeout);
+
+	if (buf) {
+		bridge_stats_rx_queue_get();
+	}
+
+	return buf;
+}
+
+void uart_rx_free(struct uart_data_t *buf)
+{
+	k_mem_slab_free(&uart_rx_data_slab, buf);
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file
+ *  @brief Continuous UART reception towards the NUS bridge
+ */
+
+#ifndef UART_RX_H_
+#define UART_RX_H_
+
+/**
+ * @brief Continuous UART reception
+ * @defgroup uart_rx UART reception
+ * @{
+ *
+ * Reception is never stopped. The UART cycles through
+ * CONFIG_BT_NUS_UART_RX_BUF_COUNT DMA buffers and every UART_RX_RDY
+ * event is copied into chunks from a fixed pool, which are queued until
+ * the BLE side takes them.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/kernel.h>
+
+/** @brief Chunk of data received from UART */
+struct uart_data_t {
+	void *fifo_reserved;
+	uint8_t data[CONFIG_BT_NUS_UART_BUFFER_SIZE];
+	uint16_t len;
+	uint32_t timestamp;
+};
+
+/**
+ * @brief Start reception
+ *
+ * The callback of @p dev must pass all events to uart_rx_event().
+ *
+ * @param dev UART device with the asynchronous API
+ *
+ * @retval 0 on success
+ * @retval -ENOMEM if no DMA buffer is available
+ * @return Other negative error code from uart_rx_enable()
+ */
+int uart_rx_start(const struct device *dev);
+
+/**
+ * @brief Handle the reception events of the UART
+ *
+ * Events not related to reception are ignored.
+ *
+ * @param evt Event passed to the UART callback
+ */
+void uart_rx_event(struct uart_event *evt);
+
+/**
+ * @brief Get the oldest received chunk
+ *
+ * @param timeout Time to wait for data
+ * @return Chunk to be released with uart_rx_free(), NULL on timeout
+ */
+struct uart_data_t *uart_rx_get(k_timeout_t timeout);
+
+/**
+ * @brief Return a chunk to the pool
+ *
+ * @param buf Chunk from uart_rx_get()
+ */
+void uart_rx_free(struct uart_data_t *buf);
+
+/** @} */
+
+#endif /* UART_RX_H_ */
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+"""Decode the sensor_thingy binary accelerometer stream.
+
+Reads frames from a serial port or a file (for example an RTT channel
+dumped with JLinkRTTLogger), checks their CRC and sample indices, and
+writes the samples as CSV. Lost samples and corrupted frames are
+reported on stderr.
+
+    accel_decode.py --port /dev/ttyACM0 --baud 115200 > samples.csv
+    accel_decode.py --file rtt_channel1.bin > samples.csv
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+VERSION = 1
+HDR = struct.Struct("<2sBBIIH")
+SAMPLE = struct.Struct("<hhh")
+
+
+def crc16_ccitt_false(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Decoder:
+    def __init__(self):
+        self.buf = bytearray()
+        self.next_seq = None
+        self.frames = 0
+        self.samples = 0
+        self.lost = 0
+        self.crc_errors = 0
+        self.skipped_bytes = 0
+
+    def feed(self, data):
+        """Yield (seq, timestamp_us, odr_hz, samples) for every valid frame."""
+        self.buf += data
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # Keep a possible first sync byte
+                keep = 1 if self.buf[-1:] == SYNC[:1] else 0
+                self.skipped_bytes += len(self.buf) - keep
+                del self.buf[:len(self.buf) - keep]
+                return
+            if start:
+                self.skipped_bytes += start
+                del self.buf[:start]
+            if len(self.buf) < HDR.size:
+                return
+
+            _, version, count, seq, timestamp, odr = HDR.unpack_from(self.buf)
+            size = HDR.size + count * SAMPLE.size + 2
+            if version != VERSION:
+                self._resync()
+                continue
+            if len(self.buf) < size:
+                return
+
+            crc, = struct.unpack_from("<H", self.buf, size - 2)
+            if crc != crc16_ccitt_false(self.buf[2:size - 2]):
+                self.crc_errors += 1
+                self._resync()
+                continue
+
+            samples = [SAMPLE.unpack_from(self.buf, HDR.size + i * SAMPLE.size)
+                       for i in range(count)]
+            del self.buf[:size]
+            self._account(seq, count)
+            yield seq, timestamp, odr, samples
+
+    def _resync(self):
+        # Drop the sync word and look for the next one
+        self.skipped_bytes += 2
+        del self.buf[:2]
+
+    def _account(self, seq, count):
+        if self.next_seq is not None and seq != self.next_seq:
+            gap = (seq - self.next_seq) & 0xFFFFFFFF
+            self.lost += gap
+            print(f"lost {gap} samples before #{seq}", file=sys.stderr)
+        self.next_seq = (seq + count) & 0xFFFFFFFF
+        self.frames += 1
+        self.samples += count
+
+    def summary(self):
+        return (f"{self.frames} frames, {self.samples} samples, {self.lost} lost, "
+                f"{self.crc_errors} CRC errors, {self.skipped_bytes} bytes skipped")
+
+
+def chunks(args):
+    if args.port:
+        import serial  # pyserial
+        with serial.Serial(args.port, args.baud, timeout=1) as port:
+            while True:
+                yield port.read(4096)
+    else:
+        with open(args.file, "rb") if args.file != "-" else sys.stdin.buffer as f:
+            while True:
+                data = f.read(4096)
+                if not data:
+                    return
+                yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port carrying the stream")
+    source.add_argument("--file", help="recorded stream, - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    out = sys.stdout
+    out.write("seq,time_us,x_mg,y_mg,z_mg\n")
+
+    try:
+        for data in chunks(args):
+            for seq, timestamp, odr, samples in decoder.feed(data):
+                # The timestamp belongs to the last sample of the frame
+                period_us = 1e6 / odr if odr else 0
+                last = len(samples) - 1
+                for i, (x, y, z) in enumerate(samples):
+                    t = timestamp - (last - i) * period_us
+                    out.write(f"{seq + i},{t:.0f},{x},{y},{z}\n")
+    except KeyboardInterrupt:
+        pass
+
+    print(decoder.summary(), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
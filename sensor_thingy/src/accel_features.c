@@ -0,0 +1,221 @@
+#include "accel_features.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arm_math.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+#include <zephyr/timing/timing.h>
+#endif
+
+LOG_MODULE_REGISTER(accel_features, LOG_LEVEL_INF);
+
+#define WINDOW CONFIG_ACCEL_FEATURE_WINDOW
+#define BINS (WINDOW / 2)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(WINDOW), "The window is also the FFT length");
+BUILD_ASSERT(CONFIG_ACCEL_FEATURE_BANDS < BINS);
+
+static accel_features_cb_t features_cb;
+static arm_rfft_instance_q15 rfft;
+
+static q15_t window[3][WINDOW];
+static size_t fill;
+static uint32_t window_seq;
+static uint32_t next_seq;
+static bool started;
+
+/* rfft output is complex and twice the window length */
+static q15_t scratch[WINDOW];
+static q15_t spectrum[2 * WINDOW];
+static q15_t mag[BINS];
+
+static struct accel_features features;
+
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+static arm_rfft_fast_instance_f32 rfft_f32;
+static float32_t window_f32[3][WINDOW];
+static float32_t scratch_f32[WINDOW];
+static float32_t spectrum_f32[WINDOW];
+#endif
+
+static q15_t mg_to_q15(int16_t mg)
+{
+	return (q15_t)CLAMP((int32_t)mg << 4, INT16_MIN, INT16_MAX);
+}
+
+static uint16_t zero_crossings(const q15_t *buf)
+{
+	uint16_t count = 0;
+
+	for (size_t i = 1; i < WINDOW; i++) {
+		count += (buf[i - 1] < 0) != (buf[i] < 0);
+	}
+
+	return count;
+}
+
+static void axis_features(q15_t *buf, struct accel_axis_features *out)
+{
+	q15_t mean;
+	uint32_t idx;
+
+	arm_mean_q15(buf, WINDOW, &mean);
+	arm_offset_q15(buf, -mean, buf, WINDOW);
+
+	arm_rms_q15(buf, WINDOW, &out->rms);
+	arm_abs_q15(buf, scratch, WINDOW);
+	arm_max_q15(scratch, WINDOW, &out->peak, &idx);
+	out->zero_crossings = zero_crossings(buf);
+
+	/* The q15 rfft modifies its input, so it runs last */
+	arm_rfft_q15(&rfft, buf, spectrum);
+	arm_cmplx_mag_squared_q15(spectrum, mag, BINS);
+
+	/* Bin 0 is the removed mean */
+	for (size_t b = 0; b < CONFIG_ACCEL_FEATURE_BANDS; b++) {
+		size_t first = 1 + (b * (BINS - 1)) / CONFIG_ACCEL_FEATURE_BANDS;
+		size_t last = 1 + ((b + 1) * (BINS - 1)) / CONFIG_ACCEL_FEATURE_BANDS;
+
+		out->bands[b] = 0;
+		for (size_t i = first; i < last; i++) {
+			out->bands[b] += (uint16_t)mag[i];
+		}
+	}
+}
+
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+/* Same features in float, only the RMS is compared */
+static float32_t axis_features_f32(float32_t *buf)
+{
+	float32_t mean;
+	float32_t rms;
+	float32_t peak;
+	uint32_t idx;
+	uint16_t crossings = 0;
+
+	arm_mean_f32(buf, WINDOW, &mean);
+	arm_offset_f32(buf, -mean, buf, WINDOW);
+
+	arm_rms_f32(buf, WINDOW, &rms);
+	arm_abs_f32(buf, scratch_f32, WINDOW);
+	arm_max_f32(scratch_f32, WINDOW, &peak, &idx);
+	for (size_t i = 1; i < WINDOW; i++) {
+		crossings += (buf[i - 1] < 0) != (buf[i] < 0);
+	}
+
+	arm_rfft_fast_f32(&rfft_f32, buf, spectrum_f32, 0);
+	arm_cmplx_mag_squared_f32(spectrum_f32, scratch_f32, BINS);
+
+	(void)peak;
+	(void)crossings;
+
+	return rms;
+}
+
+static void window_reference(void)
+{
+	timing_t start = timing_counter_get();
+	float32_t rms[3];
+
+	for (size_t axis = 0; axis < 3; axis++) {
+		rms[axis] = axis_features_f32(window_f32[axis]);
+	}
+
+	timing_t end = timing_counter_get();
+
+	features.ref_cycles = timing_cycles_get(&start, &end);
+	features.ref_rms_error = 0;
+
+	for (size_t axis = 0; axis < 3; axis++) {
+		int32_t ref = (int32_t)(rms[axis] * 32768.0f);
+		int32_t diff = ref - features.axis[axis].rms;
+
+		features.ref_rms_error = MAX(features.ref_rms_error, (int16_t)MIN(abs(diff),
+									    INT16_MAX));
+	}
+}
+
+static void window_put_f32(size_t idx, const struct accel_sample *s)
+{
+	window_f32[0][idx] = (float32_t)mg_to_q15(s->x) / 32768.0f;
+	window_f32[1][idx] = (float32_t)mg_to_q15(s->y) / 32768.0f;
+	window_f32[2][idx] = (float32_t)mg_to_q15(s->z) / 32768.0f;
+}
+#endif /* CONFIG_ACCEL_FEATURES_BENCHMARK */
+
+static void window_process(void)
+{
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+	timing_t start = timing_counter_get();
+#endif
+
+	features.seq = window_seq;
+	for (size_t axis = 0; axis < 3; axis++) {
+		axis_features(window[axis], &features.axis[axis]);
+	}
+
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+	timing_t end = timing_counter_get();
+
+	features.cycles = timing_cycles_get(&start, &end);
+	window_reference();
+#endif
+
+	features_cb(&features);
+}
+
+int accel_features_init(accel_features_cb_t cb)
+{
+	if (arm_rfft_init_q15(&rfft, WINDOW, 0, 1) != ARM_MATH_SUCCESS) {
+		LOG_ERR("Unsupported FFT length %u", WINDOW);
+		return -EINVAL;
+	}
+
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+	if (arm_rfft_fast_init_f32(&rfft_f32, WINDOW) != ARM_MATH_SUCCESS) {
+		return -EINVAL;
+	}
+
+	timing_init();
+	timing_start();
+#endif
+
+	features_cb = cb;
+
+	return 0;
+}
+
+void accel_features_add(const struct accel_burst *burst)
+{
+	/* Windows only cover consecutive samples */
+	if (started && (burst->seq != next_seq)) {
+		LOG_WRN("Gap of %u samples, window restarted", burst->seq - next_seq);
+		fill = 0;
+	}
+	started = true;
+	next_seq = burst->seq + burst->count;
+
+	for (size_t i = 0; i < burst->count; i++) {
+		const struct accel_sample *s = &burst->samples[i];
+
+		if (fill == 0) {
+			window_seq = burst->seq + i;
+		}
+
+		window[0][fill] = mg_to_q15(s->x);
+		window[1][fill] = mg_to_q15(s->y);
+		window[2][fill] = mg_to_q15(s->z);
+#if defined(CONFIG_ACCEL_FEATURES_BENCHMARK)
+		window_put_f32(fill, s);
+#endif
+
+		if (++fill == WINDOW) {
+			window_process();
+			fill = 0;
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef ACCEL_FEATURES_H_
+#define ACCEL_FEATURES_H_
+
+#include "accel_fifo.h"
+
+/*
+ * Windowed feature extraction in q15.
+ *
+ * Samples are scaled so that q15 full scale is 2.048 g (mg << 4) and
+ * collected per axis into windows of CONFIG_ACCEL_FEATURE_WINDOW samples.
+ * Every window has its mean removed and yields RMS, peak, zero crossings
+ * and the energy of CONFIG_ACCEL_FEATURE_BANDS equal width bands of its
+ * real FFT. A gap in the sample index restarts the window.
+ */
+
+struct accel_axis_features {
+	/* q15, full scale 2.048 g */
+	int16_t rms;
+	int16_t peak;
+	uint16_t zero_crossings;
+	/* Sum of the q3.13 squared magnitudes of the band's FFT bins. The q15
+	 * FFT scales its output down by the window length.
+	 */
+	uint32_t bands[CONFIG_ACCEL_FEATURE_BANDS];
+};
+
+struct accel_features {
+	/* Index of the first sample of the window */
+	uint32_t seq;
+	struct accel_axis_features axis[3];
+	/* CPU cycles spent on the window, 0 without the benchmark */
+	uint32_t cycles;
+	/* Float reference, only with CONFIG_ACCEL_FEATURES_BENCHMARK */
+	uint32_t ref_cycles;
+	/* Largest RMS difference to the float reference, in q15 */
+	int16_t ref_rms_error;
+};
+
+typedef void (*accel_features_cb_t)(const struct accel_features *features);
+
+int accel_features_init(accel_features_cb_t cb);
+
+/* Add a burst, cb is called for every window it completes */
+void accel_features_add(const struct accel_burst *burst);
+
+/* Convert a q15 value of struct accel_axis_features to mg */
+static inline int32_t accel_features_q15_to_mg(int16_t val)
+{
+	return val >> 4;
+}
+
+#endif /* ACCEL_FEATURES_H_ */
@@ -0,0 +1,495 @@
+#include "accel_fifo.h"
+
+#include <errno.h>
+#include <stddef.h>
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(accel_fifo, LOG_LEVEL_INF);
+
+#define ADXL362_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(adi_adxl362)
+
+#define ADXL362_CMD_WRITE_REG		0x0A
+#define ADXL362_CMD_READ_REG		0x0B
+#define ADXL362_CMD_READ_FIFO		0x0D
+
+#define ADXL362_REG_PARTID		0x02
+#define ADXL362_REG_STATUS		0x0B
+#define ADXL362_REG_SOFT_RESET		0x1F
+#define ADXL362_REG_THRESH_ACT_L	0x20
+#define ADXL362_REG_THRESH_ACT_H	0x21
+#define ADXL362_REG_TIME_ACT		0x22
+#define ADXL362_REG_THRESH_INACT_L	0x23
+#define ADXL362_REG_THRESH_INACT_H	0x24
+#define ADXL362_REG_TIME_INACT_L	0x25
+#define ADXL362_REG_TIME_INACT_H	0x26
+#define ADXL362_REG_ACT_INACT_CTL	0x27
+#define ADXL362_REG_FIFO_CONTROL	0x28
+#define ADXL362_REG_FIFO_SAMPLES	0x29
+#define ADXL362_REG_INTMAP1		0x2A
+#define ADXL362_REG_FILTER_CTL		0x2C
+#define ADXL362_REG_POWER_CTL		0x2D
+
+#define ADXL362_PARTID			0xF2
+#define ADXL362_RESET_KEY		0x52
+
+#define ADXL362_STATUS_FIFO_WATERMARK	BIT(2)
+#define ADXL362_STATUS_FIFO_OVERRUN	BIT(3)
+#define ADXL362_STATUS_ACT		BIT(4)
+#define ADXL362_STATUS_INACT		BIT(5)
+
+#define ADXL362_FIFO_CTL_AH		BIT(3)
+#define ADXL362_FIFO_CTL_DISABLED	0x00
+#define ADXL362_FIFO_CTL_STREAM		0x02
+
+#define ADXL362_INTMAP_FIFO_WATERMARK	BIT(2)
+#define ADXL362_INTMAP_ACT		BIT(4)
+#define ADXL362_INTMAP_INACT		BIT(5)
+
+/* Referenced activity and inactivity, linked so they alternate */
+#define ADXL362_ACT_INACT_LINKED	0x1F
+
+#define ADXL362_FILTER_RANGE_2G		0x00
+
+#define ADXL362_POWER_MEASURE		0x02
+#define ADXL362_POWER_AUTOSLEEP		BIT(2)
+
+/* FIFO entries: channel in bits 15:14, sign extended 14-bit value below */
+#define ADXL362_FIFO_CH_X		0
+#define ADXL362_FIFO_CH_Y		1
+#define ADXL362_FIFO_CH_Z		2
+
+#define FIFO_ENTRIES (CONFIG_ACCEL_FIFO_WATERMARK * 3)
+
+/* Bursts are ring items, stored without their unused samples */
+#define BURST_HDR_SIZE offsetof(struct accel_burst, samples)
+#define BURST_WORDS(_count) \
+	DIV_ROUND_UP(BURST_HDR_SIZE + ((_count) * sizeof(struct accel_sample)), 4)
+
+BUILD_ASSERT(FIFO_ENTRIES <= 511, "ADXL362 FIFO holds 511 entries");
+BUILD_ASSERT(BURST_WORDS(CONFIG_ACCEL_FIFO_WATERMARK) <= UINT8_MAX,
+	     "Burst does not fit a ring item");
+BUILD_ASSERT((sizeof(struct accel_burst) % 4) == 0);
+
+static const struct spi_dt_spec bus = SPI_DT_SPEC_GET(ADXL362_NODE,
+	SPI_WORD_SET(8) | SPI_TRANSFER_MSB | SPI_OP_MODE_MASTER, 0);
+static const struct gpio_dt_spec int1 = GPIO_DT_SPEC_GET(ADXL362_NODE, int1_gpios);
+
+/* Each item also takes one word of ring header */
+RING_BUF_ITEM_DECLARE(sample_ring, CONFIG_ACCEL_RING_BURSTS *
+		      (BURST_WORDS(CONFIG_ACCEL_FIFO_WATERMARK) + 1));
+static K_SEM_DEFINE(sample_sem, 0, K_SEM_MAX_LIMIT);
+
+static struct gpio_callback int1_cb;
+static struct k_work fifo_work;
+
+/* Burst buffer and the sample being assembled across bursts */
+static uint8_t fifo_raw[FIFO_ENTRIES * 2];
+static struct accel_burst burst __aligned(4);
+static struct accel_sample partial;
+static uint8_t partial_axes;
+static uint32_t sample_seq;
+static uint32_t irq_timestamp_us;
+
+static struct accel_fifo_stats stats;
+static uint16_t fifo_odr_hz;
+
+#if defined(CONFIG_ACCEL_POWER_STATES)
+static struct accel_power_stats power;
+static int64_t state_since_ms;
+static uint32_t wake_irq_us;
+static bool wake_pending;
+#endif
+
+static int reg_write(uint8_t reg, uint8_t val)
+{
+	uint8_t cmd[] = { ADXL362_CMD_WRITE_REG, reg, val };
+	const struct spi_buf tx_buf = { .buf = cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+
+	return spi_write_dt(&bus, &tx);
+}
+
+static int reg_read(uint8_t reg, uint8_t *val)
+{
+	uint8_t cmd[] = { ADXL362_CMD_READ_REG, reg };
+	const struct spi_buf tx_buf = { .buf = cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	const struct spi_buf rx_bufs[] = {
+		{ .buf = NULL, .len = sizeof(cmd) },
+		{ .buf = val, .len = 1 },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_bufs, .count = ARRAY_SIZE(rx_bufs) };
+
+	return spi_transceive_dt(&bus, &tx, &rx);
+}
+
+static int odr_bits(uint16_t odr_hz)
+{
+	/* 12.5 Hz is requested as 12 */
+	static const uint16_t rates[] = { 12, 25, 50, 100, 200, 400 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(rates); i++) {
+		if (rates[i] == odr_hz) {
+			return i;
+		}
+	}
+
+	return -EINVAL;
+}
+
+static size_t fifo_parse(size_t entries)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < entries; i++) {
+		uint16_t entry = sys_get_le16(&fifo_raw[2 * i]);
+		int16_t val = (int16_t)(entry << 2) >> 2;
+
+		/* A sample is X, Y, Z in order. After an overrun the FIFO may
+		 * start mid sample; entries are skipped until the next X.
+		 */
+		switch (entry >> 14) {
+		case ADXL362_FIFO_CH_X:
+			partial.x = val;
+			partial_axes = 1;
+			break;
+		case ADXL362_FIFO_CH_Y:
+			partial.y = val;
+			partial_axes = (partial_axes == 1) ? 2 : 0;
+			break;
+		case ADXL362_FIFO_CH_Z:
+			partial.z = val;
+			if (partial_axes == 2) {
+				burst.samples[count++] = partial;
+			}
+			partial_axes = 0;
+			break;
+		default:
+			partial_axes = 0;
+			break;
+		}
+	}
+
+	return count;
+}
+
+static int fifo_burst_read(void)
+{
+	uint8_t cmd = ADXL362_CMD_READ_FIFO;
+	const struct spi_buf tx_buf = { .buf = &cmd, .len = 1 };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	const struct spi_buf rx_bufs[] = {
+		{ .buf = NULL, .len = 1 },
+		{ .buf = fifo_raw, .len = sizeof(fifo_raw) },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_bufs, .count = ARRAY_SIZE(rx_bufs) };
+	int err;
+
+	/* The watermark guarantees this many entries are waiting */
+	err = spi_transceive_dt(&bus, &tx, &rx);
+	if (err) {
+		LOG_ERR("FIFO read failed (err %d)", err);
+		return err;
+	}
+
+	burst.count = fifo_parse(FIFO_ENTRIES);
+	burst.seq = sample_seq;
+#if defined(CONFIG_ACCEL_POWER_STATES)
+	if (wake_pending) {
+		wake_pending = false;
+		power.wake_latency_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()) -
+					wake_irq_us;
+	}
+#endif
+	burst.timestamp_us = irq_timestamp_us;
+	sample_seq += burst.count;
+	stats.interrupts++;
+
+	if (!burst.count) {
+		return 0;
+	}
+
+	/* Only this work item puts, so the ring needs no lock */
+	err = ring_buf_item_put(&sample_ring, 0, 0, (uint32_t *)&burst,
+				BURST_WORDS(burst.count));
+	if (err) {
+		stats.ring_drops += burst.count;
+		return 0;
+	}
+
+	stats.samples += burst.count;
+	k_sem_give(&sample_sem);
+
+	return 0;
+}
+
+static int fifo_stream_start(void)
+{
+	int err;
+
+	partial_axes = 0;
+
+	/* Disabling empties the FIFO */
+	err = reg_write(ADXL362_REG_FIFO_CONTROL, ADXL362_FIFO_CTL_DISABLED);
+	err = err ? err : reg_write(ADXL362_REG_FIFO_SAMPLES, FIFO_ENTRIES & 0xFF);
+	return err ? err : reg_write(ADXL362_REG_FIFO_CONTROL, ADXL362_FIFO_CTL_STREAM |
+				     ((FIFO_ENTRIES > 0xFF) ? ADXL362_FIFO_CTL_AH : 0));
+}
+
+#if defined(CONFIG_ACCEL_POWER_STATES)
+static void state_time_account(void)
+{
+	int64_t now = k_uptime_get();
+	uint32_t elapsed = (uint32_t)(now - state_since_ms);
+
+	if (power.state == ACCEL_POWER_ACTIVE) {
+		power.active_ms += elapsed;
+	} else {
+		power.idle_ms += elapsed;
+	}
+	state_since_ms = now;
+}
+
+/* With autosleep the sensor drops to its wake-up mode on its own, the
+ * FIFO is stopped and only activity is left on INT1.
+ */
+static void enter_idle(void)
+{
+	int err;
+
+	err = reg_write(ADXL362_REG_INTMAP1, ADXL362_INTMAP_ACT);
+	err = err ? err : reg_write(ADXL362_REG_FIFO_CONTROL, ADXL362_FIFO_CTL_DISABLED);
+	if (err) {
+		LOG_ERR("Idle transition failed (err %d)", err);
+		return;
+	}
+
+	state_time_account();
+	power.state = ACCEL_POWER_IDLE;
+	power.to_idle++;
+	power.sleep_latency_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()) -
+				 irq_timestamp_us;
+	LOG_INF("Inactive, waiting for motion");
+}
+
+static void enter_active(void)
+{
+	int err;
+
+	err = fifo_stream_start();
+	err = err ? err : reg_write(ADXL362_REG_INTMAP1, ADXL362_INTMAP_FIFO_WATERMARK |
+				    ADXL362_INTMAP_INACT);
+	if (err) {
+		LOG_ERR("Active transition failed (err %d)", err);
+		return;
+	}
+
+	/* Samples not taken while idle still count, downstream sees a gap */
+	sample_seq += (uint32_t)((k_uptime_get() - state_since_ms) * fifo_odr_hz / 1000);
+
+	state_time_account();
+	power.state = ACCEL_POWER_ACTIVE;
+	power.to_active++;
+	wake_irq_us = irq_timestamp_us;
+	wake_pending = true;
+	LOG_INF("Motion, streaming at %u Hz", fifo_odr_hz);
+}
+
+/* Returns true when the interrupt was a state change */
+static bool power_state_update(uint8_t status)
+{
+	if (power.state == ACCEL_POWER_IDLE) {
+		if (status & ADXL362_STATUS_ACT) {
+			enter_active();
+		}
+		return true;
+	}
+
+	if (status & ADXL362_STATUS_INACT) {
+		enter_idle();
+		return true;
+	}
+
+	return false;
+}
+
+static int power_states_init(void)
+{
+	uint16_t thresh_act = CONFIG_ACCEL_ACT_THRESHOLD_MG;
+	uint16_t thresh_inact = CONFIG_ACCEL_INACT_THRESHOLD_MG;
+	uint32_t time_inact = MIN((uint32_t)CONFIG_ACCEL_INACT_TIME_MS * fifo_odr_hz / 1000,
+				  UINT16_MAX);
+	int err;
+
+	/* At +-2 g thresholds are in mg, times in samples */
+	err = reg_write(ADXL362_REG_THRESH_ACT_L, thresh_act & 0xFF);
+	err = err ? err : reg_write(ADXL362_REG_THRESH_ACT_H, (thresh_act >> 8) & 0x07);
+	err = err ? err : reg_write(ADXL362_REG_TIME_ACT, CONFIG_ACCEL_ACT_TIME_SAMPLES);
+	err = err ? err : reg_write(ADXL362_REG_THRESH_INACT_L, thresh_inact & 0xFF);
+	err = err ? err : reg_write(ADXL362_REG_THRESH_INACT_H, (thresh_inact >> 8) & 0x07);
+	err = err ? err : reg_write(ADXL362_REG_TIME_INACT_L, time_inact & 0xFF);
+	err = err ? err : reg_write(ADXL362_REG_TIME_INACT_H, time_inact >> 8);
+	err = err ? err : reg_write(ADXL362_REG_ACT_INACT_CTL, ADXL362_ACT_INACT_LINKED);
+
+	power.state = ACCEL_POWER_ACTIVE;
+	state_since_ms = k_uptime_get();
+
+	return err;
+}
+#endif /* CONFIG_ACCEL_POWER_STATES */
+
+static void fifo_work_handler(struct k_work *work)
+{
+	uint8_t status;
+
+	/* Without power states the watermark is the only interrupt source */
+	if (!IS_ENABLED(CONFIG_ACCEL_POWER_STATES)) {
+		while ((fifo_burst_read() == 0) && (gpio_pin_get_dt(&int1) > 0)) {
+			/* Still above the watermark, we fell behind the sensor */
+			if ((reg_read(ADXL362_REG_STATUS, &status) == 0) &&
+			    (status & ADXL362_STATUS_FIFO_OVERRUN)) {
+				stats.overruns++;
+			}
+		}
+		return;
+	}
+
+#if defined(CONFIG_ACCEL_POWER_STATES)
+	/* INT1 is shared, the status tells the source */
+	if (reg_read(ADXL362_REG_STATUS, &status)) {
+		return;
+	}
+
+	if (status & ADXL362_STATUS_FIFO_OVERRUN) {
+		stats.overruns++;
+	}
+
+	if (power_state_update(status) || !(status & ADXL362_STATUS_FIFO_WATERMARK)) {
+		return;
+	}
+
+	if ((fifo_burst_read() == 0) && (gpio_pin_get_dt(&int1) > 0)) {
+		k_work_submit(&fifo_work);
+	}
+#endif
+}
+
+static void int1_handler(const struct device *port, struct gpio_callback *cb,
+			 gpio_port_pins_t pins)
+{
+	irq_timestamp_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+	k_work_submit(&fifo_work);
+}
+
+int accel_fifo_init(uint16_t odr_hz)
+{
+	uint8_t partid = 0;
+	int odr = odr_bits(odr_hz);
+	int err;
+
+	if (odr < 0) {
+		LOG_ERR("Unsupported ODR %u Hz", odr_hz);
+		return odr;
+	}
+
+	if (!spi_is_ready_dt(&bus) || !gpio_is_ready_dt(&int1)) {
+		LOG_ERR("ADXL362 bus not ready");
+		return -ENODEV;
+	}
+
+	k_work_init(&fifo_work, fifo_work_handler);
+
+	err = reg_write(ADXL362_REG_SOFT_RESET, ADXL362_RESET_KEY);
+	if (err) {
+		return err;
+	}
+	k_sleep(K_MSEC(1));
+
+	err = reg_read(ADXL362_REG_PARTID, &partid);
+	if (err || (partid != ADXL362_PARTID)) {
+		LOG_ERR("ADXL362 not found (err %d, id 0x%02x)", err, partid);
+		return err ? err : -ENODEV;
+	}
+
+	fifo_odr_hz = odr_hz;
+
+	err = reg_write(ADXL362_REG_FILTER_CTL, ADXL362_FILTER_RANGE_2G | odr);
+	err = err ? err : fifo_stream_start();
+#if defined(CONFIG_ACCEL_POWER_STATES)
+	err = err ? err : power_states_init();
+	err = err ? err : reg_write(ADXL362_REG_INTMAP1, ADXL362_INTMAP_FIFO_WATERMARK |
+				    ADXL362_INTMAP_INACT);
+#else
+	err = err ? err : reg_write(ADXL362_REG_INTMAP1, ADXL362_INTMAP_FIFO_WATERMARK);
+#endif
+	if (err) {
+		LOG_ERR("ADXL362 configuration failed (err %d)", err);
+		return err;
+	}
+
+	err = gpio_pin_configure_dt(&int1, GPIO_INPUT);
+	if (err) {
+		return err;
+	}
+
+	gpio_init_callback(&int1_cb, int1_handler, BIT(int1.pin));
+	err = gpio_add_callback(int1.port, &int1_cb);
+	if (err) {
+		return err;
+	}
+
+	err = gpio_pin_interrupt_configure_dt(&int1, GPIO_INT_EDGE_TO_ACTIVE);
+	if (err) {
+		return err;
+	}
+
+	LOG_INF("ADXL362 at %u Hz, %u samples per interrupt", odr_hz,
+		CONFIG_ACCEL_FIFO_WATERMARK);
+
+	return reg_write(ADXL362_REG_POWER_CTL, ADXL362_POWER_MEASURE |
+			 (IS_ENABLED(CONFIG_ACCEL_POWER_STATES) ? ADXL362_POWER_AUTOSLEEP : 0));
+}
+
+int accel_fifo_get(struct accel_burst *out, k_timeout_t timeout)
+{
+	uint16_t type;
+	uint8_t value;
+	uint8_t words = sizeof(*out) / 4;
+	int err;
+
+	/* One count per burst in the ring */
+	err = k_sem_take(&sample_sem, timeout);
+	if (err) {
+		return err;
+	}
+
+	return ring_buf_item_get(&sample_ring, &type, &value, (uint32_t *)out, &words);
+}
+
+void accel_fifo_stats_get(struct accel_fifo_stats *out)
+{
+	*out = stats;
+}
+
+#if defined(CONFIG_ACCEL_POWER_STATES)
+void accel_fifo_power_stats_get(struct accel_power_stats *out)
+{
+	*out = power;
+
+	/* Include the time spent so far in the current state */
+	uint32_t elapsed = (uint32_t)(k_uptime_get() - state_since_ms);
+
+	if (out->state == ACCEL_POWER_ACTIVE) {
+		out->active_ms += elapsed;
+	} else {
+		out->idle_ms += elapsed;
+	}
+}
+#endif
@@ -0,0 +1,84 @@
+#ifndef ACCEL_FIFO_H_
+#define ACCEL_FIFO_H_
+
+#include <zephyr/kernel.h>
+
+/*
+ * ADXL362 sampling through its FIFO.
+ *
+ * The FIFO runs in stream mode with the watermark mapped to INT1, so the
+ * MCU is interrupted once per CONFIG_ACCEL_FIFO_WATERMARK samples and
+ * drains them in a single SPI transaction into a ring of fixed-point
+ * samples. The Zephyr ADXL362 driver does not expose the FIFO, so the
+ * part is driven directly on its devicetree SPI bus.
+ */
+
+/* One sample in mg, at +-2 g this is the raw 12-bit value */
+struct accel_sample {
+	int16_t x;
+	int16_t y;
+	int16_t z;
+};
+
+/* Samples read from the FIFO in one transaction */
+struct accel_burst {
+	/* Index of the first sample since start. Samples dropped in the ring
+	 * still advance it, so gaps show up downstream.
+	 */
+	uint32_t seq;
+	/* Uptime in us of the watermark interrupt, about when the last
+	 * sample was taken
+	 */
+	uint32_t timestamp_us;
+	uint16_t count;
+	struct accel_sample samples[CONFIG_ACCEL_FIFO_WATERMARK];
+};
+
+struct accel_fifo_stats {
+	/* Watermark interrupts serviced */
+	uint32_t interrupts;
+	/* Samples put in the ring */
+	uint32_t samples;
+	/* Samples lost because the ring was full, whole bursts are dropped */
+	uint32_t ring_drops;
+	/* FIFO overruns seen, the sensor discarded samples */
+	uint32_t overruns;
+};
+
+/* Configure the sensor and start sampling at odr_hz */
+int accel_fifo_init(uint16_t odr_hz);
+
+/* Take the oldest burst out of the ring, waiting up to timeout for one */
+int accel_fifo_get(struct accel_burst *burst, k_timeout_t timeout);
+
+void accel_fifo_stats_get(struct accel_fifo_stats *stats);
+
+enum accel_power_state {
+	/* Streaming at the configured ODR through the FIFO */
+	ACCEL_POWER_ACTIVE,
+	/* Sensor in autosleep wake-up mode, only motion interrupts */
+	ACCEL_POWER_IDLE,
+};
+
+struct accel_power_stats {
+	enum accel_power_state state;
+	uint32_t to_idle;
+	uint32_t to_active;
+	uint32_t active_ms;
+	uint32_t idle_ms;
+	/* Inactivity interrupt to FIFO stopped, last transition */
+	uint32_t sleep_latency_us;
+	/* Activity interrupt to the first full rate burst, last transition */
+	uint32_t wake_latency_us;
+};
+
+/*
+ * With CONFIG_ACCEL_POWER_STATES the sensor watches for inactivity while
+ * streaming. After CONFIG_ACCEL_INACT_TIME_MS below the inactivity
+ * threshold it autosleeps into its wake-up mode, the FIFO is stopped and
+ * the MCU only waits for the activity interrupt that restarts streaming.
+ * INT1 is then shared, so each interrupt costs one extra status read.
+ */
+void accel_fifo_power_stats_get(struct accel_power_stats *stats);
+
+#endif /* ACCEL_FIFO_H_ */
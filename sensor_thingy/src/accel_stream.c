@@ -0,0 +1,156 @@
+#include "accel_stream.h"
+
+#include <errno.h>
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_ACCEL_STREAM_UART)
+#include <zephyr/drivers/uart.h>
+#else
+#include <SEGGER_RTT.h>
+#endif
+
+LOG_MODULE_REGISTER(accel_stream, LOG_LEVEL_INF);
+
+#define FRAME_MAX ACCEL_STREAM_FRAME_SIZE(CONFIG_ACCEL_FIFO_WATERMARK)
+
+BUILD_ASSERT(CONFIG_ACCEL_FIFO_WATERMARK <= UINT8_MAX);
+
+static uint16_t stream_odr_hz;
+static uint32_t dropped;
+
+static size_t frame_encode(uint8_t *frame, const struct accel_burst *burst)
+{
+	uint8_t *pos = frame;
+
+	sys_put_le16(ACCEL_STREAM_SYNC, pos);
+	pos[2] = ACCEL_STREAM_VERSION;
+	pos[3] = burst->count;
+	sys_put_le32(burst->seq, &pos[4]);
+	sys_put_le32(burst->timestamp_us, &pos[8]);
+	sys_put_le16(stream_odr_hz, &pos[12]);
+	pos += ACCEL_STREAM_HDR_SIZE;
+
+	for (size_t i = 0; i < burst->count; i++) {
+		sys_put_le16(burst->samples[i].x, &pos[0]);
+		sys_put_le16(burst->samples[i].y, &pos[2]);
+		sys_put_le16(burst->samples[i].z, &pos[4]);
+		pos += 6;
+	}
+
+	/* The sync word is left out so it does not bias the check */
+	sys_put_le16(crc16_itu_t(0xFFFF, &frame[2], pos - &frame[2]), pos);
+	pos += 2;
+
+	return pos - frame;
+}
+
+#if defined(CONFIG_ACCEL_STREAM_UART)
+
+static const struct device *const uart = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+
+/* One frame is encoded while the other one is sent */
+static uint8_t frames[2][FRAME_MAX];
+static uint8_t frame_idx;
+static K_SEM_DEFINE(tx_idle, 1, 1);
+
+static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+	switch (evt->type) {
+	case UART_TX_DONE:
+		k_sem_give(&tx_idle);
+		break;
+	case UART_TX_ABORTED:
+		dropped++;
+		k_sem_give(&tx_idle);
+		break;
+	default:
+		break;
+	}
+}
+
+static int transport_init(void)
+{
+	if (!device_is_ready(uart)) {
+		return -ENODEV;
+	}
+
+	return uart_callback_set(uart, uart_cb, NULL);
+}
+
+static int transport_send(const struct accel_burst *burst)
+{
+	uint8_t *frame = frames[frame_idx];
+	size_t len = frame_encode(frame, burst);
+	int err;
+
+	k_sem_take(&tx_idle, K_FOREVER);
+
+	err = uart_tx(uart, frame, len, SYS_FOREVER_US);
+	if (err) {
+		dropped++;
+		k_sem_give(&tx_idle);
+		return err;
+	}
+
+	frame_idx ^= 1;
+
+	return 0;
+}
+
+#else /* CONFIG_ACCEL_STREAM_RTT */
+
+static uint8_t rtt_buf[CONFIG_ACCEL_STREAM_RTT_BUF_SIZE];
+static uint8_t frame[FRAME_MAX];
+
+static int transport_init(void)
+{
+	/* Frames are written whole or not at all */
+	int err = SEGGER_RTT_ConfigUpBuffer(CONFIG_ACCEL_STREAM_RTT_CHANNEL, "accel",
+					    rtt_buf, sizeof(rtt_buf),
+					    SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+
+	return (err < 0) ? -EINVAL : 0;
+}
+
+static int transport_send(const struct accel_burst *burst)
+{
+	size_t len = frame_encode(frame, burst);
+
+	if (SEGGER_RTT_Write(CONFIG_ACCEL_STREAM_RTT_CHANNEL, frame, len) != len) {
+		dropped++;
+		return -ENOBUFS;
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_ACCEL_STREAM_UART */
+
+int accel_stream_init(uint16_t odr_hz)
+{
+	int err;
+
+	stream_odr_hz = odr_hz;
+
+	err = transport_init();
+	if (err) {
+		LOG_ERR("Stream transport init failed (err %d)", err);
+	}
+
+	return err;
+}
+
+int accel_stream_send(const struct accel_burst *burst)
+{
+	return transport_send(burst);
+}
+
+uint32_t accel_stream_dropped_get(void)
+{
+	return dropped;
+}
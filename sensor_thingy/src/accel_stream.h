@@ -0,0 +1,33 @@
+#ifndef ACCEL_STREAM_H_
+#define ACCEL_STREAM_H_
+
+#include "accel_fifo.h"
+
+/*
+ * Binary frames, one per FIFO burst, all fields little-endian:
+ *
+ *   0  u16  sync, 0xA5 0x5A on the wire
+ *   2  u8   version
+ *   3  u8   sample count n
+ *   4  u32  index of the first sample, gaps mean lost samples
+ *   8  u32  timestamp in us of the last sample
+ *  12  u16  output data rate in Hz
+ *  14  n * (i16 x, i16 y, i16 z) in mg
+ *  14 + 6n  u16 CRC-16/CCITT-FALSE of bytes 2 to 14 + 6n - 1
+ */
+
+#define ACCEL_STREAM_SYNC 0x5AA5
+#define ACCEL_STREAM_VERSION 1
+#define ACCEL_STREAM_HDR_SIZE 14
+#define ACCEL_STREAM_FRAME_SIZE(_count) \
+	(ACCEL_STREAM_HDR_SIZE + ((_count) * 6) + 2)
+
+int accel_stream_init(uint16_t odr_hz);
+
+/* Send one burst. Blocks while both frame buffers are in flight. */
+int accel_stream_send(const struct accel_burst *burst);
+
+/* Frames the transport could not take */
+uint32_t accel_stream_dropped_get(void);
+
+#endif /* ACCEL_STREAM_H_ */
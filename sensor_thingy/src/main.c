@@ -1,48 +1,126 @@
 #include <zephyr/kernel.h>
 #include <zephyr/sys/printk.h>
-#include <zephyr/drivers/sensor.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-static void imu_trigger_handler(const struct device *dev,
-	const struct sensor_trigger *trig)
+#include "accel_fifo.h"
+#if defined(CONFIG_ACCEL_OUTPUT_BINARY)
+#include "accel_stream.h"
+#endif
+#if defined(CONFIG_ACCEL_OUTPUT_FEATURES)
+#include "accel_features.h"
+#endif
+
+#define STATS_INTERVAL_MS 10000
+
+static struct accel_burst burst;
+
+#if defined(CONFIG_ACCEL_OUTPUT_TEXT)
+/* Prints mg as g with three decimals, no float formatting needed */
+static void print_sample(const struct accel_sample *s)
+{
+	printf("%s%d.%03d\t%s%d.%03d\t%s%d.%03d\r\n",
+		(s->x < 0) ? "-" : "", abs(s->x) / 1000, abs(s->x) % 1000,
+		(s->y < 0) ? "-" : "", abs(s->y) / 1000, abs(s->y) % 1000,
+		(s->z < 0) ? "-" : "", abs(s->z) / 1000, abs(s->z) % 1000);
+}
+#endif
+
+#if defined(CONFIG_ACCEL_OUTPUT_FEATURES)
+static void print_features(const struct accel_features *f)
 {
-	struct sensor_value accel[3];
-	sensor_sample_fetch(dev);
-	sensor_channel_get(dev, SENSOR_CHAN_ACCEL_XYZ, accel);
-	printf("%.3f\t%.3f\t%.3f\r\n",
-		sensor_value_to_double(&accel[0]),
-		sensor_value_to_double(&accel[1]),
-		sensor_value_to_double(&accel[2]));
+	static const char axis_names[] = "xyz";
+
+	printk("#%u", f->seq);
+	for (size_t axis = 0; axis < 3; axis++) {
+		const struct accel_axis_features *a = &f->axis[axis];
+
+		printk(" %c: rms %d peak %d mg zc %u bands", axis_names[axis],
+			accel_features_q15_to_mg(a->rms), accel_features_q15_to_mg(a->peak),
+			a->zero_crossings);
+		for (size_t b = 0; b < CONFIG_ACCEL_FEATURE_BANDS; b++) {
+			printk(" %u", a->bands[b]);
+		}
+	}
+	printk("\n");
+
+	if (IS_ENABLED(CONFIG_ACCEL_FEATURES_BENCHMARK)) {
+		printk("q15 %u cycles, f32 %u cycles, rms error %d q15\n",
+			f->cycles, f->ref_cycles, f->ref_rms_error);
+	}
 }
+#endif
 
+static void output_burst(const struct accel_burst *b)
+{
+#if defined(CONFIG_ACCEL_OUTPUT_BINARY)
+	accel_stream_send(b);
+#elif defined(CONFIG_ACCEL_OUTPUT_FEATURES)
+	accel_features_add(b);
+#elif defined(CONFIG_ACCEL_OUTPUT_TEXT)
+	for (size_t i = 0; i < b->count; i++) {
+		print_sample(&b->samples[i]);
+	}
+#endif
+}
+
+static void print_stats(void)
+{
+	struct accel_fifo_stats stats;
+
+	accel_fifo_stats_get(&stats);
+	printk("%u interrupts, %u samples, %u ring drops, %u overruns\n",
+		stats.interrupts, stats.samples, stats.ring_drops, stats.overruns);
+
+#if defined(CONFIG_ACCEL_OUTPUT_BINARY)
+	printk("%u frames dropped by the transport\n", accel_stream_dropped_get());
+#endif
+
+#if defined(CONFIG_ACCEL_POWER_STATES)
+	struct accel_power_stats power;
+
+	accel_fifo_power_stats_get(&power);
+	printk("%s, active %u ms, idle %u ms, %u/%u transitions, "
+		"sleep latency %u us, wake latency %u us\n",
+		(power.state == ACCEL_POWER_ACTIVE) ? "Active" : "Idle",
+		power.active_ms, power.idle_ms, power.to_idle, power.to_active,
+		power.sleep_latency_us, power.wake_latency_us);
+#endif
+}
 
 int main() {
-    setvbuf(stdout, NULL, _IONBF, 0);
-
-    const struct device *imu = DEVICE_DT_GET_ONE(adi_adxl362);
-    if (!device_is_ready(imu)) {
-        printf("imu device not ready\n");
-        return 1;
-    }
-
-	// Set scale to ±2g
-	struct sensor_value scale_val = {
-		.val1 = 2,
-		.val2 = 0,
-	};
-	sensor_attr_set(imu, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_FULL_SCALE, &scale_val);
-
-	// Set ODR to 400 Hz
-	struct sensor_value odr_val = {
-		.val1 = 400,
-		.val2 = 0,
-	};
-	sensor_attr_set(imu, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY, &odr_val);
-
-	struct sensor_trigger trig = {
-        .type = SENSOR_TRIG_DATA_READY,
-        .chan = SENSOR_CHAN_ACCEL_XYZ,
-    };
-
-    sensor_trigger_set(imu, &trig, imu_trigger_handler);
+	int err;
+	int64_t next_stats = k_uptime_get() + STATS_INTERVAL_MS;
+
+#if defined(CONFIG_ACCEL_OUTPUT_BINARY)
+	err = accel_stream_init(CONFIG_ACCEL_ODR_HZ);
+	if (err) {
+		return 1;
+	}
+#endif
+
+#if defined(CONFIG_ACCEL_OUTPUT_FEATURES)
+	err = accel_features_init(print_features);
+	if (err) {
+		return 1;
+	}
+#endif
+
+	// ±2g, ODR and watermark from Kconfig
+	err = accel_fifo_init(CONFIG_ACCEL_ODR_HZ);
+	if (err) {
+		printk("imu device not ready\n");
+		return 1;
+	}
+
+	while (1) {
+		if (accel_fifo_get(&burst, K_MSEC(STATS_INTERVAL_MS)) == 0) {
+			output_burst(&burst);
+		}
+
+		if (k_uptime_get() >= next_stats) {
+			next_stats += STATS_INTERVAL_MS;
+			print_stats();
+		}
+	}
 }
@@ -0,0 +1,284 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define DT_DRV_COMPAT adi_adxl362
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include "adxl362_emul.h"
+
+/* Only what src/accel_fifo.c uses */
+#define CMD_WRITE_REG		0x0A
+#define CMD_READ_REG		0x0B
+#define CMD_READ_FIFO		0x0D
+
+#define REG_PARTID		0x02
+#define REG_STATUS		0x0B
+#define REG_SOFT_RESET		0x1F
+#define REG_FIFO_CONTROL	0x28
+#define REG_FIFO_SAMPLES	0x29
+#define REG_INTMAP1		0x2A
+#define REG_COUNT		0x30
+
+#define PARTID			0xF2
+#define RESET_KEY		0x52
+
+#define STATUS_FIFO_WATERMARK	BIT(2)
+#define STATUS_FIFO_OVERRUN	BIT(3)
+#define FIFO_CTL_AH		BIT(3)
+#define FIFO_CTL_MODE_MASK	0x03
+#define INTMAP_FIFO_WATERMARK	BIT(2)
+
+#define FIFO_SIZE 511
+
+struct adxl362_emul_config {
+	struct gpio_dt_spec int1;
+};
+
+struct adxl362_emul_data {
+	uint8_t regs[REG_COUNT];
+	uint16_t fifo[FIFO_SIZE];
+	size_t fifo_len;
+	bool overrun;
+	uint32_t fifo_reads;
+};
+
+/* Copy the first bytes of the transaction */
+static size_t buf_set_get(const struct spi_buf_set *set, uint8_t *dst, size_t len)
+{
+	size_t pos = 0;
+
+	for (size_t i = 0; set && (i < set->count) && (pos < len); i++) {
+		size_t n = MIN(set->buffers[i].len, len - pos);
+
+		memcpy(&dst[pos], set->buffers[i].buf, n);
+		pos += n;
+	}
+
+	return pos;
+}
+
+/* Return the byte clocked out at position pos, NULL buffers skip bytes */
+static uint8_t *buf_set_at(const struct spi_buf_set *set, size_t pos)
+{
+	for (size_t i = 0; set && (i < set->count); i++) {
+		if (pos < set->buffers[i].len) {
+			return set->buffers[i].buf ? &((uint8_t *)set->buffers[i].buf)[pos] : NULL;
+		}
+		pos -= set->buffers[i].len;
+	}
+
+	return NULL;
+}
+
+static size_t buf_set_len(const struct spi_buf_set *set)
+{
+	size_t len = 0;
+
+	for (size_t i = 0; set && (i < set->count); i++) {
+		len += set->buffers[i].len;
+	}
+
+	return len;
+}
+
+static size_t watermark(const struct adxl362_emul_data *data)
+{
+	return data->regs[REG_FIFO_SAMPLES] |
+	       ((data->regs[REG_FIFO_CONTROL] & FIFO_CTL_AH) ? 0x100 : 0);
+}
+
+static void int1_update(const struct emul *target)
+{
+	const struct adxl362_emul_config *cfg = target->cfg;
+	struct adxl362_emul_data *data = target->data;
+	bool active = (data->regs[REG_INTMAP1] & INTMAP_FIFO_WATERMARK) &&
+		      (data->fifo_len >= watermark(data));
+
+	gpio_emul_input_set(cfg->int1.port, cfg->int1.pin, active);
+}
+
+static void reset(struct adxl362_emul_data *data)
+{
+	memset(data->regs, 0, sizeof(data->regs));
+	data->regs[REG_PARTID] = PARTID;
+	data->fifo_len = 0;
+	data->overrun = false;
+}
+
+static void reg_write(struct adxl362_emul_data *data, uint8_t reg, uint8_t val)
+{
+	if (reg >= REG_COUNT) {
+		return;
+	}
+
+	if ((reg == REG_SOFT_RESET) && (val == RESET_KEY)) {
+		reset(data);
+		return;
+	}
+
+	data->regs[reg] = val;
+
+	/* Disabling the FIFO empties it */
+	if ((reg == REG_FIFO_CONTROL) && !(val & FIFO_CTL_MODE_MASK)) {
+		data->fifo_len = 0;
+	}
+}
+
+static uint8_t reg_read(struct adxl362_emul_data *data, uint8_t reg)
+{
+	uint8_t val;
+
+	if (reg >= REG_COUNT) {
+		return 0;
+	}
+
+	if (reg != REG_STATUS) {
+		return data->regs[reg];
+	}
+
+	val = (data->fifo_len >= watermark(data)) ? STATUS_FIFO_WATERMARK : 0;
+	if (data->overrun) {
+		val |= STATUS_FIFO_OVERRUN;
+		data->overrun = false;
+	}
+
+	return val;
+}
+
+/* The command byte is followed by two bytes per entry */
+static void fifo_read(struct adxl362_emul_data *data, const struct spi_buf_set *rx)
+{
+	size_t len = buf_set_len(rx);
+	size_t entries = MIN((MAX(len, 1) - 1) / 2, data->fifo_len);
+
+	for (size_t i = 0; i < entries; i++) {
+		uint8_t *lo = buf_set_at(rx, 1 + (2 * i));
+		uint8_t *hi = buf_set_at(rx, 2 + (2 * i));
+
+		if (lo) {
+			*lo = data->fifo[i] & 0xFF;
+		}
+		if (hi) {
+			*hi = data->fifo[i] >> 8;
+		}
+	}
+
+	data->fifo_len -= entries;
+	memmove(data->fifo, &data->fifo[entries], data->fifo_len * sizeof(data->fifo[0]));
+	data->fifo_reads++;
+}
+
+static int adxl362_emul_io(const struct emul *target, const struct spi_config *config,
+			   const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs)
+{
+	struct adxl362_emul_data *data = target->data;
+	uint8_t cmd[3] = { 0 };
+	size_t cmd_len = buf_set_get(tx_bufs, cmd, sizeof(cmd));
+	uint8_t *val;
+
+	ARG_UNUSED(config);
+
+	switch (cmd[0]) {
+	case CMD_WRITE_REG:
+		if (cmd_len < 3) {
+			return -EIO;
+		}
+		reg_write(data, cmd[1], cmd[2]);
+		break;
+	case CMD_READ_REG:
+		val = buf_set_at(rx_bufs, 2);
+		if ((cmd_len < 2) || !val) {
+			return -EIO;
+		}
+		*val = reg_read(data, cmd[1]);
+		break;
+	case CMD_READ_FIFO:
+		fifo_read(data, rx_bufs);
+		break;
+	default:
+		return -EIO;
+	}
+
+	int1_update(target);
+
+	return 0;
+}
+
+static const struct spi_emul_api adxl362_emul_api = {
+	.io = adxl362_emul_io,
+};
+
+void adxl362_emul_fifo_push(const struct emul *target, const uint16_t *entries, size_t count)
+{
+	struct adxl362_emul_data *data = target->data;
+
+	/* Nothing is sampled while the FIFO is disabled */
+	if (!(data->regs[REG_FIFO_CONTROL] & FIFO_CTL_MODE_MASK)) {
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		/* Stream mode keeps the newest entries */
+		if (data->fifo_len == FIFO_SIZE) {
+			memmove(data->fifo, &data->fifo[1], (FIFO_SIZE - 1) * sizeof(data->fifo[0]));
+			data->fifo_len--;
+			data->overrun = true;
+		}
+		data->fifo[data->fifo_len++] = entries[i];
+	}
+
+	int1_update(target);
+}
+
+uint8_t adxl362_emul_reg_get(const struct emul *target, uint8_t reg)
+{
+	const struct adxl362_emul_data *data = target->data;
+
+	return (reg < REG_COUNT) ? data->regs[reg] : 0;
+}
+
+uint32_t adxl362_emul_fifo_reads(const struct emul *target)
+{
+	const struct adxl362_emul_data *data = target->data;
+
+	return data->fifo_reads;
+}
+
+void adxl362_emul_reset_counters(const struct emul *target)
+{
+	struct adxl362_emul_data *data = target->data;
+
+	data->fifo_reads = 0;
+}
+
+static int adxl362_emul_init(const struct emul *target, const struct device *parent)
+{
+	ARG_UNUSED(parent);
+
+	reset(target->data);
+
+	return 0;
+}
+
+#define ADXL362_EMUL_DEFINE(n)                                                 \
+	static const struct adxl362_emul_config adxl362_emul_config_##n = {    \
+		.int1 = GPIO_DT_SPEC_INST_GET(n, int1_gpios),                  \
+	};                                                                     \
+	static struct adxl362_emul_data adxl362_emul_data_##n;                 \
+	/* The emulator needs a device, the FIFO reader never uses it */       \
+	DEVICE_DT_INST_DEFINE(n, NULL, NULL, NULL, NULL, POST_KERNEL,          \
+			      CONFIG_SPI_INIT_PRIORITY, NULL);                 \
+	EMUL_DT_INST_DEFINE(n, adxl362_emul_init, &adxl362_emul_data_##n,      \
+			    &adxl362_emul_config_##n, &adxl362_emul_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(ADXL362_EMUL_DEFINE)
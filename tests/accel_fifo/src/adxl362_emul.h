@@ -0,0 +1,24 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ADXL362_EMUL_H_
+#define ADXL362_EMUL_H_
+
+#include <zephyr/drivers/emul.h>
+
+/* FIFO entry of one axis, channel 0 to 2 for X, Y and Z */
+#define ADXL362_EMUL_ENTRY(_ch, _val) ((uint16_t)(((_ch) << 14) | ((_val) & 0x3FFF)))
+
+/* Append entries to the FIFO as the sensor would while sampling. INT1
+ * follows the watermark and FIFO reads.
+ */
+void adxl362_emul_fifo_push(const struct emul *target, const uint16_t *entries, size_t count);
+
+uint8_t adxl362_emul_reg_get(const struct emul *target, uint8_t reg);
+
+/* FIFO read transactions since the last reset */
+uint32_t adxl362_emul_fifo_reads(const struct emul *target);
+void adxl362_emul_reset_counters(const struct emul *target);
+
+#endif /* ADXL362_EMUL_H_ */
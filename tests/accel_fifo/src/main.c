@@ -0,0 +1,215 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/emul.h>
+
+#include <accel_fifo.h>
+
+#include "adxl362_emul.h"
+
+#define WATERMARK CONFIG_ACCEL_FIFO_WATERMARK
+#define RING_BURSTS CONFIG_ACCEL_RING_BURSTS
+
+#define ODR_HZ 400
+/* Configuration register values for ODR_HZ at +-2 g */
+#define FILTER_CTL_400HZ 0x05
+#define FIFO_CTL_STREAM 0x02
+#define POWER_CTL_MEASURE 0x02
+#define INTMAP_FIFO_WATERMARK BIT(2)
+
+#define REG_FILTER_CTL 0x2C
+#define REG_FIFO_CONTROL 0x28
+#define REG_FIFO_SAMPLES 0x29
+#define REG_INTMAP1 0x2A
+#define REG_POWER_CTL 0x2D
+
+/* Longer than the work item reading the FIFO */
+#define SETTLE K_MSEC(10)
+
+static const struct emul *const adxl362 = EMUL_DT_GET(DT_NODELABEL(adxl362));
+
+/* Value of the next sample pushed, every axis differs and some are negative */
+static int16_t next_val;
+/* Index of the next sample expected from the reader */
+static uint32_t next_seq;
+
+static struct accel_sample sample_val(int16_t val)
+{
+	return (struct accel_sample){ .x = val, .y = -val, .z = val + 1000 };
+}
+
+static void push_entries(const uint16_t *entries, size_t count)
+{
+	adxl362_emul_fifo_push(adxl362, entries, count);
+	k_sleep(SETTLE);
+}
+
+/* Push samples as the sensor would, X, Y and Z per sample */
+static void push_samples(size_t count)
+{
+	uint16_t entries[3 * RING_BURSTS * WATERMARK];
+
+	zassert_true(count <= (ARRAY_SIZE(entries) / 3));
+
+	for (size_t i = 0; i < count; i++) {
+		struct accel_sample s = sample_val(next_val++);
+
+		entries[3 * i] = ADXL362_EMUL_ENTRY(0, s.x);
+		entries[3 * i + 1] = ADXL362_EMUL_ENTRY(1, s.y);
+		entries[3 * i + 2] = ADXL362_EMUL_ENTRY(2, s.z);
+	}
+
+	push_entries(entries, 3 * count);
+}
+
+/* Take one burst and check it continues the pushed samples */
+static void burst_expect(int16_t first_val, uint16_t count)
+{
+	struct accel_burst burst;
+
+	zassert_ok(accel_fifo_get(&burst, K_NO_WAIT), "No burst");
+	zassert_equal(burst.count, count);
+	zassert_equal(burst.seq, next_seq);
+
+	for (uint16_t i = 0; i < count; i++) {
+		struct accel_sample s = sample_val(first_val + i);
+
+		zassert_equal(burst.samples[i].x, s.x, "Sample %u", i);
+		zassert_equal(burst.samples[i].y, s.y, "Sample %u", i);
+		zassert_equal(burst.samples[i].z, s.z, "Sample %u", i);
+	}
+
+	next_seq += count;
+}
+
+static struct accel_fifo_stats stats(void)
+{
+	struct accel_fifo_stats s;
+
+	accel_fifo_stats_get(&s);
+
+	return s;
+}
+
+static void *accel_fifo_setup(void)
+{
+	zassert_ok(accel_fifo_init(ODR_HZ));
+	next_val = -(WATERMARK * 4);
+
+	return NULL;
+}
+
+static void accel_fifo_before(void *fixture)
+{
+	struct accel_burst burst;
+
+	ARG_UNUSED(fixture);
+
+	k_sleep(SETTLE);
+	zassert_equal(accel_fifo_get(&burst, K_NO_WAIT), -EBUSY, "Burst left over");
+	adxl362_emul_reset_counters(adxl362);
+}
+
+ZTEST(accel_fifo, test_config)
+{
+	uint16_t entries = 3 * WATERMARK;
+
+	zassert_equal(adxl362_emul_reg_get(adxl362, REG_FILTER_CTL), FILTER_CTL_400HZ);
+	zassert_equal(adxl362_emul_reg_get(adxl362, REG_FIFO_SAMPLES), entries & 0xFF);
+	zassert_equal(adxl362_emul_reg_get(adxl362, REG_FIFO_CONTROL),
+		      FIFO_CTL_STREAM | ((entries > 0xFF) ? BIT(3) : 0));
+	zassert_equal(adxl362_emul_reg_get(adxl362, REG_INTMAP1), INTMAP_FIFO_WATERMARK);
+	zassert_equal(adxl362_emul_reg_get(adxl362, REG_POWER_CTL), POWER_CTL_MEASURE);
+}
+
+/* Nothing is read below the watermark, then one transaction per burst */
+ZTEST(accel_fifo, test_watermark)
+{
+	struct accel_fifo_stats before = stats();
+	struct accel_fifo_stats after;
+	struct accel_burst burst;
+	int16_t first = next_val;
+
+	push_samples(WATERMARK - 1);
+	zassert_equal(accel_fifo_get(&burst, K_NO_WAIT), -EBUSY);
+	zassert_equal(adxl362_emul_fifo_reads(adxl362), 0);
+
+	push_samples(1);
+	burst_expect(first, WATERMARK);
+	zassert_equal(adxl362_emul_fifo_reads(adxl362), 1);
+
+	after = stats();
+	zassert_equal(after.interrupts - before.interrupts, 1);
+	zassert_equal(after.samples - before.samples, WATERMARK);
+}
+
+/* A reader that fell behind drains the FIFO burst by burst */
+ZTEST(accel_fifo, test_backlog)
+{
+	int16_t first = next_val;
+
+	push_samples(3 * WATERMARK);
+	zassert_equal(adxl362_emul_fifo_reads(adxl362), 3);
+
+	for (int i = 0; i < 3; i++) {
+		burst_expect(first + (i * WATERMARK), WATERMARK);
+	}
+}
+
+/* A FIFO starting mid sample is skipped up to the next X, and a sample
+ * split across two bursts is completed by the second one
+ */
+ZTEST(accel_fifo, test_partial_sample)
+{
+	const uint16_t tail[] = { ADXL362_EMUL_ENTRY(1, 0), ADXL362_EMUL_ENTRY(2, 0) };
+	int16_t first = next_val;
+	struct accel_sample s;
+
+	/* Y, Z and WATERMARK samples, the read stops after the last X */
+	push_entries(tail, ARRAY_SIZE(tail));
+	push_samples(WATERMARK);
+	burst_expect(first, WATERMARK - 1);
+
+	/* Y and Z of the split sample come first */
+	push_samples(WATERMARK);
+	burst_expect(first + WATERMARK - 1, WATERMARK);
+
+	/* Realign: WATERMARK - 1 samples and a lone X fill the next read */
+	push_samples(WATERMARK - 1);
+	s = sample_val(next_val);
+	push_entries((const uint16_t[]){ ADXL362_EMUL_ENTRY(0, s.x) }, 1);
+	burst_expect(first + (2 * WATERMARK) - 1, WATERMARK);
+	zassert_equal(adxl362_emul_fifo_reads(adxl362), 3);
+}
+
+/* Bursts the application does not take in time are dropped whole and
+ * the sequence shows the gap
+ */
+ZTEST(accel_fifo, test_ring_full)
+{
+	struct accel_fifo_stats before = stats();
+	struct accel_fifo_stats after;
+	int16_t first = next_val;
+
+	for (int i = 0; i < RING_BURSTS + 2; i++) {
+		push_samples(WATERMARK);
+	}
+
+	after = stats();
+	zassert_equal(after.ring_drops - before.ring_drops, 2 * WATERMARK);
+	zassert_equal(adxl362_emul_fifo_reads(adxl362), RING_BURSTS + 2);
+
+	for (int i = 0; i < RING_BURSTS; i++) {
+		burst_expect(first + (i * WATERMARK), WATERMARK);
+	}
+
+	next_seq += 2 * WATERMARK;
+	first = next_val;
+	push_samples(WATERMARK);
+	burst_expect(first, WATERMARK);
+}
+
+ZTEST_SUITE(accel_fifo, NULL, accel_fifo_setup, accel_fifo_before, NULL, NULL);
@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+
+#include <debounce.h>
+
+#define STABLE_MS (CONFIG_DEBOUNCE_SAMPLE_MS * CONFIG_DEBOUNCE_STABLE_SAMPLES)
+/* Long enough for any burst to be sampled to the end */
+#define SETTLE_MS (2 * STABLE_MS + CONFIG_DEBOUNCE_SAMPLE_MS)
+
+#define EVENTS_MAX 8
+
+static const struct gpio_dt_spec button = GPIO_DT_SPEC_GET(DT_PATH(zephyr_user), button_gpios);
+static struct debounce_input input;
+
+static struct debounce_event events[EVENTS_MAX];
+static size_t event_count;
+
+/* One step of a bounce pattern, the level is held for hold_ms */
+struct step {
+	uint8_t level;
+	uint8_t hold_ms;
+};
+
+static void debounced(struct debounce_input *in, const struct debounce_event *evt)
+{
+	if (event_count < EVENTS_MAX) {
+		events[event_count] = *evt;
+	}
+	event_count++;
+}
+
+static void pin_set(int level)
+{
+	zassert_ok(gpio_emul_input_set(button.port, button.pin, level));
+}
+
+static void pattern_play(const struct step *steps, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		pin_set(steps[i].level);
+		k_sleep(K_MSEC(steps[i].hold_ms));
+	}
+}
+
+static void *debounce_setup(void)
+{
+	zassert_true(gpio_is_ready_dt(&button));
+	zassert_ok(debounce_input_init(&input, &button, debounced));
+
+	return NULL;
+}
+
+static void debounce_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	pin_set(0);
+	k_sleep(K_MSEC(SETTLE_MS));
+	zassert_false(debounce_input_level(&input));
+	event_count = 0;
+}
+
+ZTEST(debounce, test_clean_press_release)
+{
+	pin_set(1);
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	zassert_equal(event_count, 1);
+	zassert_equal(events[0].type, DEBOUNCE_PRESSED);
+	zassert_equal(events[0].bounces, 0);
+	zassert_true(debounce_input_level(&input));
+
+	k_sleep(K_MSEC(100));
+	pin_set(0);
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	zassert_equal(event_count, 2);
+	zassert_equal(events[1].type, DEBOUNCE_RELEASED);
+	zassert_within(events[1].duration_ms, 100 + SETTLE_MS, CONFIG_DEBOUNCE_SAMPLE_MS);
+}
+
+ZTEST(debounce, test_bouncing_press)
+{
+	/* Edges at a shorter period than the sample interval, so samples
+	 * land on both levels before the contact settles
+	 */
+	static const struct step press[] = {
+		{ 1, 3 }, { 0, 3 }, { 1, 3 }, { 0, 3 }, { 1, 2 }, { 0, 2 }, { 1, 0 },
+	};
+
+	pattern_play(press, ARRAY_SIZE(press));
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	zassert_equal(event_count, 1, "one press per burst, got %u events", event_count);
+	zassert_equal(events[0].type, DEBOUNCE_PRESSED);
+	zassert_true(events[0].bounces > 0);
+}
+
+ZTEST(debounce, test_bouncing_release)
+{
+	static const struct step release[] = {
+		{ 0, 2 }, { 1, 4 }, { 0, 1 }, { 1, 6 }, { 0, 0 },
+	};
+
+	pin_set(1);
+	k_sleep(K_MSEC(SETTLE_MS));
+	pattern_play(release, ARRAY_SIZE(release));
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	zassert_equal(event_count, 2);
+	zassert_equal(events[0].type, DEBOUNCE_PRESSED);
+	zassert_equal(events[1].type, DEBOUNCE_RELEASED);
+	zassert_false(debounce_input_level(&input));
+}
+
+ZTEST(debounce, test_glitch_ignored)
+{
+	/* Shorter than the stable time, the level never changes */
+	static const struct step glitch[] = {
+		{ 1, 1 }, { 0, CONFIG_DEBOUNCE_SAMPLE_MS }, { 1, 1 }, { 0, 0 },
+	};
+
+	pattern_play(glitch, ARRAY_SIZE(glitch));
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	zassert_equal(event_count, 0);
+	zassert_false(debounce_input_level(&input));
+}
+
+ZTEST(debounce, test_short_press)
+{
+	/* Released right after the press settled and the pin was unmasked */
+	pin_set(1);
+	k_sleep(K_MSEC(STABLE_MS + CONFIG_DEBOUNCE_SAMPLE_MS));
+	pin_set(0);
+	k_sleep(K_MSEC(SETTLE_MS));
+
+	zassert_equal(event_count, 2);
+	zassert_equal(events[0].type, DEBOUNCE_PRESSED);
+	zassert_equal(events[1].type, DEBOUNCE_RELEASED);
+}
+
+ZTEST_SUITE(debounce, NULL, debounce_setup, debounce_before, NULL, NULL);
@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define DT_DRV_COMPAT test_i2c_id_target
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+
+#include <string.h>
+
+#include "id_target.h"
+
+struct id_target_config {
+	uint8_t id_reg;
+	const uint8_t *id;
+	size_t id_len;
+};
+
+struct id_target_data {
+	uint8_t regs[256];
+	/* Register pointer, auto-incremented by reads */
+	uint8_t ptr;
+	uint32_t reg_writes;
+};
+
+static int id_target_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs,
+			      int addr)
+{
+	struct id_target_data *data = target->data;
+
+	ARG_UNUSED(addr);
+
+	for (int i = 0; i < num_msgs; i++) {
+		struct i2c_msg *msg = &msgs[i];
+
+		if (msg->flags & I2C_MSG_READ) {
+			for (uint32_t j = 0; j < msg->len; j++) {
+				msg->buf[j] = data->regs[data->ptr++];
+			}
+		} else if (msg->len) {
+			/* The first byte written sets the pointer */
+			data->ptr = msg->buf[0];
+			data->reg_writes++;
+		}
+	}
+
+	return 0;
+}
+
+static const struct i2c_emul_api id_target_api = {
+	.transfer = id_target_transfer,
+};
+
+static int id_target_init(const struct emul *target, const struct device *parent)
+{
+	const struct id_target_config *cfg = target->cfg;
+	struct id_target_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	memcpy(&data->regs[cfg->id_reg], cfg->id, cfg->id_len);
+
+	return 0;
+}
+
+uint32_t id_target_reg_writes(const struct emul *target)
+{
+	const struct id_target_data *data = target->data;
+
+	return data->reg_writes;
+}
+
+void id_target_reset(const struct emul *target)
+{
+	struct id_target_data *data = target->data;
+
+	data->ptr = 0;
+	data->reg_writes = 0;
+}
+
+#define ID_TARGET_DEFINE(n)                                                    \
+	BUILD_ASSERT(DT_INST_PROP(n, id_reg) + DT_INST_PROP_LEN(n, id) <= 256, \
+		     "ID does not fit the register map");                      \
+	static const uint8_t id_target_id_##n[] = DT_INST_PROP(n, id);         \
+	static const struct id_target_config id_target_config_##n = {          \
+		.id_reg = DT_INST_PROP(n, id_reg),                             \
+		.id = id_target_id_##n,                                        \
+		.id_len = sizeof(id_target_id_##n),                            \
+	};                                                                     \
+	static struct id_target_data id_target_data_##n;                       \
+	/* The emulator needs a device, the scanner never uses it */           \
+	DEVICE_DT_INST_DEFINE(n, NULL, NULL, NULL, NULL, POST_KERNEL,          \
+			      CONFIG_I2C_INIT_PRIORITY, NULL);                 \
+	EMUL_DT_INST_DEFINE(n, id_target_init, &id_target_data_##n,            \
+			    &id_target_config_##n, &id_target_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(ID_TARGET_DEFINE)
@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ID_TARGET_H_
+#define ID_TARGET_H_
+
+#include <zephyr/drivers/emul.h>
+
+/* Register pointer writes since the last reset, one per ID register
+ * read by the fingerprinting
+ */
+uint32_t id_target_reg_writes(const struct emul *target);
+void id_target_reset(const struct emul *target);
+
+#endif /* ID_TARGET_H_ */
@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/emul.h>
+
+#include <string.h>
+
+#include <scanner.h>
+#include <fingerprint.h>
+
+#include "id_target.h"
+
+#define BUS0_DEVICES 5
+#define BUS1_DEVICES 6
+
+static const struct device *const bus0 = DEVICE_DT_GET(DT_NODELABEL(i2c_scan0));
+static const struct device *const bus1 = DEVICE_DT_GET(DT_NODELABEL(i2c_scan1));
+
+/* Expected scan of bus0, in address order */
+static const struct scanner_device bus0_expected[] = {
+	{ 0x18, "LIS3DH/LIS2DH12" },
+	{ 0x48, "TMP117" },
+	{ 0x68, "ICM-20948" },
+	{ 0x76, "BME280" },
+	{ 0x77, NULL },
+};
+
+BUILD_ASSERT(ARRAY_SIZE(bus0_expected) == BUS0_DEVICES);
+BUILD_ASSERT(BUS1_DEVICES > CONFIG_SCANNER_MAX_DEVICES);
+
+static void device_check(const struct scanner_device *dev,
+			 const struct scanner_device *expected)
+{
+	zassert_equal(dev->addr, expected->addr, "0x%02x found instead of 0x%02x",
+		      dev->addr, expected->addr);
+
+	if (expected->name) {
+		zassert_not_null(dev->name, "0x%02x not identified", dev->addr);
+		zassert_ok(strcmp(dev->name, expected->name), "0x%02x identified as %s",
+			   dev->addr, dev->name);
+	} else {
+		zassert_is_null(dev->name, "0x%02x identified as %s", dev->addr, dev->name);
+	}
+}
+
+static void *scanner_setup(void)
+{
+	zassert_true(device_is_ready(bus0));
+	zassert_true(device_is_ready(bus1));
+
+	return NULL;
+}
+
+ZTEST(scanner, test_probe)
+{
+	zassert_ok(scanner_probe(bus0, 0x18));
+	zassert_not_ok(scanner_probe(bus0, 0x19));
+}
+
+ZTEST(scanner, test_scan)
+{
+	struct scanner_result result;
+
+	zassert_ok(scanner_scan(bus0, &result));
+
+	zassert_equal(result.bus, bus0);
+	zassert_ok(result.err);
+	/* The emulated controller takes every speed */
+	zassert_equal(result.speed_hz, IS_ENABLED(CONFIG_SCANNER_FAST_PLUS) ? 1000000 : 400000);
+	zassert_equal(result.found, BUS0_DEVICES);
+	zassert_true(result.probe_us <= result.scan_us);
+
+	for (size_t i = 0; i < BUS0_DEVICES; i++) {
+		device_check(&result.devices[i], &bus0_expected[i]);
+	}
+}
+
+ZTEST(scanner, test_scan_overflow)
+{
+	struct scanner_result result;
+
+	zassert_ok(scanner_scan(bus1, &result));
+
+	/* Counted, but only the first ones are recorded */
+	zassert_equal(result.found, BUS1_DEVICES);
+	for (size_t i = 0; i < CONFIG_SCANNER_MAX_DEVICES; i++) {
+		zassert_equal(result.devices[i].addr, 0x20 + i);
+		zassert_is_null(result.devices[i].name);
+	}
+}
+
+ZTEST(scanner, test_scan_all)
+{
+	const struct device *const buses[] = { bus0, bus1 };
+	struct scanner_result results[ARRAY_SIZE(buses)];
+	uint32_t total_us;
+
+	zassert_ok(scanner_scan_all(buses, ARRAY_SIZE(buses), results, &total_us));
+
+	zassert_equal(results[0].bus, bus0);
+	zassert_equal(results[0].found, BUS0_DEVICES);
+	zassert_equal(results[1].bus, bus1);
+	zassert_equal(results[1].found, BUS1_DEVICES);
+}
+
+ZTEST(scanner, test_scan_all_too_many)
+{
+	const struct device *buses[CONFIG_SCANNER_MAX_BUSES + 1];
+	struct scanner_result results[ARRAY_SIZE(buses)];
+	uint32_t total_us;
+
+	for (size_t i = 0; i < ARRAY_SIZE(buses); i++) {
+		buses[i] = bus0;
+	}
+
+	zassert_equal(scanner_scan_all(buses, ARRAY_SIZE(buses), results, &total_us), -EINVAL);
+}
+
+ZTEST(fingerprint, test_identify)
+{
+	for (size_t i = 0; i < BUS0_DEVICES; i++) {
+		const char *name = fingerprint_identify(bus0, bus0_expected[i].addr);
+
+		if (bus0_expected[i].name) {
+			zassert_not_null(name, "0x%02x not identified", bus0_expected[i].addr);
+			zassert_ok(strcmp(name, bus0_expected[i].name));
+		} else {
+			zassert_is_null(name);
+		}
+	}
+}
+
+ZTEST(fingerprint, test_no_device)
+{
+	zassert_is_null(fingerprint_identify(bus0, 0x19));
+}
+
+ZTEST(fingerprint, test_shared_register_read_once)
+{
+	const struct emul *bme280 = EMUL_DT_GET(DT_NODELABEL(bme280));
+	const struct emul *icm20948 = EMUL_DT_GET(DT_NODELABEL(icm20948));
+
+	/* Four parts at 0x76 share register 0xD0 */
+	id_target_reset(bme280);
+	zassert_not_null(fingerprint_identify(bus0, 0x76));
+	zassert_equal(id_target_reg_writes(bme280), 1);
+
+	/* The MPU parts share 0x75 and come before the parts on 0x00 */
+	id_target_reset(icm20948);
+	zassert_not_null(fingerprint_identify(bus0, 0x68));
+	zassert_equal(id_target_reg_writes(icm20948), 2);
+}
+
+ZTEST_SUITE(scanner, NULL, scanner_setup, NULL, NULL, NULL);
+ZTEST_SUITE(fingerprint, NULL, scanner_setup, NULL, NULL, NULL);
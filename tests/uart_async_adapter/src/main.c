@@ -0,0 +1,234 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+
+#include <string.h>
+
+#include <uart_async_adapter.h>
+
+#define RX_FIFO_SIZE DT_PROP(DT_NODELABEL(euart0), rx_fifo_size)
+
+#define RX_BUF_SIZE 64
+/* The adapter holds two buffers at most, one more is being copied from */
+#define RX_BUF_COUNT 4
+/* The adapter takes the RX timeout in milliseconds */
+#define RX_TIMEOUT_MS 20
+
+/* Longer than the RX timeout and the emulator work items */
+#define SETTLE K_MSEC(50)
+
+/* Sent while no buffer is available, more than both buffers hold */
+#define STARVED_BYTES (2 * RX_BUF_SIZE + 64)
+BUILD_ASSERT((CONFIG_BT_NUS_UART_ASYNC_ADAPTER_RX_RING_SIZE == 0) ||
+	     (CONFIG_BT_NUS_UART_ASYNC_ADAPTER_RX_RING_SIZE >= STARVED_BYTES),
+	     "The starvation test expects the ring to absorb everything");
+
+#define BENCH_BYTES (64 * 1024)
+
+UART_ASYNC_ADAPTER_INST_DEFINE(async_adapter);
+
+static const struct device *const target = DEVICE_DT_GET(DT_NODELABEL(euart0));
+
+static uint8_t rx_bufs[RX_BUF_COUNT][RX_BUF_SIZE];
+static size_t rx_buf_next;
+/* Buffer requests are left unanswered while set */
+static bool rx_starve;
+
+static uint8_t rx_data[1024];
+static size_t rx_len;
+static uint8_t tx_pattern_next;
+static uint8_t rx_pattern_next;
+
+static K_SEM_DEFINE(tx_done, 0, 1);
+static size_t tx_done_len;
+
+static void rx_buf_provide(void)
+{
+	zassert_ok(uart_rx_buf_rsp(async_adapter, rx_bufs[rx_buf_next], RX_BUF_SIZE));
+	rx_buf_next = (rx_buf_next + 1) % RX_BUF_COUNT;
+}
+
+static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+
+	switch (evt->type) {
+	case UART_TX_DONE:
+		tx_done_len = evt->data.tx.len;
+		k_sem_give(&tx_done);
+		break;
+
+	case UART_RX_RDY:
+		if (rx_len + evt->data.rx.len <= sizeof(rx_data)) {
+			memcpy(&rx_data[rx_len], &evt->data.rx.buf[evt->data.rx.offset],
+			       evt->data.rx.len);
+		}
+		rx_len += evt->data.rx.len;
+		break;
+
+	case UART_RX_BUF_REQUEST:
+		if (!rx_starve) {
+			rx_buf_provide();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Received bytes in chunks the emulated FIFO takes at once */
+static void rx_feed(size_t len)
+{
+	uint8_t chunk[RX_FIFO_SIZE];
+
+	while (len) {
+		size_t n = MIN(len, sizeof(chunk));
+
+		for (size_t i = 0; i < n; i++) {
+			chunk[i] = tx_pattern_next++;
+		}
+		zassert_equal(uart_emul_put_rx_data(target, chunk, n), n);
+		/* Let the interrupt handler drain the FIFO */
+		k_sleep(K_TICKS(1));
+		len -= n;
+	}
+}
+
+/* Check the first len received bytes continue the sent pattern */
+static void rx_expect(size_t len)
+{
+	zassert_true(len <= sizeof(rx_data));
+
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(rx_data[i], rx_pattern_next, "Byte %zu is 0x%02x, not 0x%02x", i,
+			      rx_data[i], rx_pattern_next);
+		rx_pattern_next++;
+	}
+}
+
+static struct uart_async_adapter_stats stats(void)
+{
+	struct uart_async_adapter_stats s;
+
+	zassert_ok(uart_async_adapter_stats_get(async_adapter, &s));
+
+	return s;
+}
+
+static void *adapter_setup(void)
+{
+	uart_async_adapter_init(async_adapter, target);
+	zassert_ok(uart_callback_set(async_adapter, uart_cb, NULL));
+	zassert_ok(uart_rx_enable(async_adapter, rx_bufs[0], RX_BUF_SIZE, RX_TIMEOUT_MS));
+	rx_buf_next = 1;
+
+	return NULL;
+}
+
+static void adapter_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	k_sleep(SETTLE);
+	uart_emul_flush_tx_data(target);
+	rx_starve = false;
+	rx_len = 0;
+	/* Bytes dropped by an earlier test are not expected any more */
+	rx_pattern_next = tx_pattern_next;
+}
+
+ZTEST(uart_async_adapter, test_rx)
+{
+	struct uart_async_adapter_stats before = stats();
+	struct uart_async_adapter_stats after;
+
+	rx_feed(sizeof(rx_data));
+	k_sleep(SETTLE);
+	after = stats();
+
+	zassert_equal(rx_len, sizeof(rx_data));
+	rx_expect(rx_len);
+	zassert_equal(after.rx_bytes - before.rx_bytes, sizeof(rx_data));
+	zassert_equal(after.rx_dropped, before.rx_dropped);
+}
+
+/* Data received while the user holds back buffers is kept by the ring
+ * and handed over by the RX timeout, or dropped and counted without it
+ */
+ZTEST(uart_async_adapter, test_rx_starved)
+{
+	struct uart_async_adapter_stats before = stats();
+	struct uart_async_adapter_stats after;
+
+	rx_starve = true;
+	rx_feed(STARVED_BYTES);
+
+	/* Answer the pending request before the RX timeout expires */
+	rx_starve = false;
+	rx_buf_provide();
+	k_sleep(SETTLE);
+	after = stats();
+
+	zassert_equal(after.rx_bytes - before.rx_bytes, STARVED_BYTES);
+	if (CONFIG_BT_NUS_UART_ASYNC_ADAPTER_RX_RING_SIZE > 0) {
+		zassert_equal(rx_len, STARVED_BYTES);
+		zassert_equal(after.rx_dropped, before.rx_dropped);
+	} else {
+		zassert_true(after.rx_dropped > before.rx_dropped);
+		zassert_equal(rx_len + (after.rx_dropped - before.rx_dropped), STARVED_BYTES);
+	}
+	rx_expect(rx_len);
+}
+
+ZTEST(uart_async_adapter, test_tx)
+{
+	static uint8_t tx_buf[200];
+	uint8_t sent[sizeof(tx_buf)];
+
+	for (size_t i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = i;
+	}
+
+	zassert_ok(uart_tx(async_adapter, tx_buf, sizeof(tx_buf), SYS_FOREVER_MS));
+	zassert_ok(k_sem_take(&tx_done, K_MSEC(100)));
+	zassert_equal(tx_done_len, sizeof(tx_buf));
+
+	zassert_equal(uart_emul_get_tx_data(target, sent, sizeof(sent)), sizeof(sent));
+	zassert_mem_equal(sent, tx_buf, sizeof(tx_buf));
+}
+
+/* CPU cycles spent in the adapter interrupt handler per received byte,
+ * for comparing changes to the adapter, not real UARTs
+ */
+ZTEST(uart_async_adapter, test_rx_isr_cycles)
+{
+	struct uart_async_adapter_stats before = stats();
+	struct uart_async_adapter_stats after;
+	uint32_t bytes;
+	uint32_t isrs;
+	uint64_t cycles;
+
+	rx_feed(BENCH_BYTES);
+	k_sleep(SETTLE);
+	after = stats();
+
+	bytes = after.rx_bytes - before.rx_bytes;
+	isrs = after.isr_count - before.isr_count;
+	cycles = after.isr_cycles - before.isr_cycles;
+
+	zassert_equal(bytes, BENCH_BYTES);
+	zassert_equal(rx_len, BENCH_BYTES);
+	zassert_equal(after.rx_dropped, before.rx_dropped);
+
+	TC_PRINT("%u bytes in %u interrupts: %u cycles per byte, %u cycles per interrupt\n",
+		 bytes, isrs, (uint32_t)(cycles / bytes), (uint32_t)(cycles / MAX(isrs, 1)));
+}
+
+ZTEST_SUITE(uart_async_adapter, NULL, adapter_setup, adapter_before, NULL, NULL);
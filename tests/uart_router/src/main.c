@@ -0,0 +1,280 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <uart_router.h>
+
+#define PORT_DEV(node, prop, idx) DEVICE_DT_GET(DT_PHANDLE_BY_IDX(node, prop, idx)),
+
+static const struct device *const uarts[] = {
+	DT_FOREACH_PROP_ELEM(DT_PATH(zephyr_user), uart_router_ports, PORT_DEV)
+};
+
+#define PORT_COUNT ARRAY_SIZE(uarts)
+#define PAIR_A 0
+#define PAIR_B 1
+#define BROADCASTER 2
+#define TAGGER 3
+
+BUILD_ASSERT(PORT_COUNT == 4, "The tests use one port per routing rule");
+
+#define TX_QUEUE_LEN CONFIG_UART_ROUTER_TX_QUEUE_LEN
+/* Lines sent at once by the overflow test */
+#define BURST_LINES (TX_QUEUE_LEN + 3)
+
+/* Longer than the RX idle timeout and the emulator work items */
+#define SETTLE K_MSEC(20)
+
+#define THROUGHPUT_LINES 200
+/* Lines in flight at once, they fit the TX queue of the destination */
+#define THROUGHPUT_BURST TX_QUEUE_LEN
+
+static char out[1024];
+
+static void rx_feed(uint8_t port, const char *str)
+{
+	size_t len = strlen(str);
+
+	zassert_equal(uart_emul_put_rx_data(uarts[port], (const uint8_t *)str, len), len);
+}
+
+/* Everything the port sent since the last call, as a string */
+static const char *tx_take(uint8_t port)
+{
+	uint32_t len = uart_emul_get_tx_data(uarts[port], (uint8_t *)out, sizeof(out) - 1);
+
+	out[len] = '\0';
+
+	return out;
+}
+
+static void tx_expect(uint8_t port, const char *expected)
+{
+	const char *sent = tx_take(port);
+
+	zassert_ok(strcmp(sent, expected), "Uart%u sent \"%s\" instead of \"%s\"", port, sent,
+		   expected);
+}
+
+static void tx_expect_none(uint8_t except)
+{
+	for (uint8_t i = 0; i < PORT_COUNT; i++) {
+		if (i != except) {
+			tx_expect(i, "");
+		}
+	}
+}
+
+static struct uart_router_port_stats stats(uint8_t port)
+{
+	struct uart_router_port_stats s;
+
+	zassert_ok(uart_router_stats_get(port, &s));
+
+	return s;
+}
+
+static void *router_setup(void)
+{
+	zassert_ok(uart_router_init());
+	zassert_equal(uart_router_port_count(), PORT_COUNT);
+
+	zassert_ok(uart_router_route_add(PAIR_A, PAIR_B));
+	zassert_ok(uart_router_route_add(PAIR_B, PAIR_A));
+	zassert_ok(uart_router_route_add(BROADCASTER, UART_ROUTER_ALL));
+	zassert_ok(uart_router_route_add(TAGGER, UART_ROUTER_TAGGED));
+
+	return NULL;
+}
+
+static void router_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	k_sleep(SETTLE);
+	for (uint8_t i = 0; i < PORT_COUNT; i++) {
+		uart_emul_flush_tx_data(uarts[i]);
+	}
+}
+
+ZTEST(uart_router, test_route_add_invalid)
+{
+	zassert_equal(uart_router_route_add(PORT_COUNT, 0), -EINVAL);
+	zassert_equal(uart_router_route_add(0, PORT_COUNT), -EINVAL);
+}
+
+ZTEST(uart_router, test_pair)
+{
+	rx_feed(PAIR_A, "ping\n");
+	k_sleep(SETTLE);
+	tx_expect(PAIR_B, "From Uart0: ping\r\n");
+	tx_expect_none(PAIR_B);
+
+	rx_feed(PAIR_B, "pong\r");
+	k_sleep(SETTLE);
+	tx_expect(PAIR_A, "From Uart1: pong\r\n");
+	tx_expect_none(PAIR_A);
+}
+
+ZTEST(uart_router, test_broadcast)
+{
+	rx_feed(BROADCASTER, "to all\n");
+	k_sleep(SETTLE);
+
+	for (uint8_t i = 0; i < PORT_COUNT; i++) {
+		tx_expect(i, (i == BROADCASTER) ? "" : "From Uart2: to all\r\n");
+	}
+}
+
+ZTEST(uart_router, test_tagged)
+{
+	uint32_t unrouted = stats(TAGGER).unrouted;
+
+	rx_feed(TAGGER, "@1 one\n");
+	k_sleep(SETTLE);
+	tx_expect(1, "From Uart3: one\r\n");
+	tx_expect_none(1);
+
+	rx_feed(TAGGER, "@* many\n");
+	k_sleep(SETTLE);
+	for (uint8_t i = 0; i < PORT_COUNT; i++) {
+		tx_expect(i, (i == TAGGER) ? "" : "From Uart3: many\r\n");
+	}
+
+	/* Untagged, and to a port that does not exist */
+	rx_feed(TAGGER, "plain\n@9 nowhere\n");
+	k_sleep(SETTLE);
+	tx_expect_none(PORT_COUNT);
+	zassert_equal(stats(TAGGER).unrouted - unrouted, 2);
+}
+
+ZTEST(uart_router, test_truncate)
+{
+	char line[CONFIG_UART_ROUTER_LINE_SIZE + 8];
+	char expected[sizeof("From Uart0: ") + CONFIG_UART_ROUTER_LINE_SIZE + 2];
+	uint32_t truncated = stats(PAIR_A).rx_truncated_bytes;
+
+	memset(line, 'x', sizeof(line) - 2);
+	line[sizeof(line) - 2] = '\n';
+	line[sizeof(line) - 1] = '\0';
+	snprintf(expected, sizeof(expected), "From Uart0: %.*s\r\n", CONFIG_UART_ROUTER_LINE_SIZE,
+		 line);
+
+	rx_feed(PAIR_A, line);
+	k_sleep(SETTLE);
+	tx_expect(PAIR_B, expected);
+	zassert_equal(stats(PAIR_A).rx_truncated_bytes - truncated,
+		      sizeof(line) - 2 - CONFIG_UART_ROUTER_LINE_SIZE);
+}
+
+/* Queue more lines than fit while the emulator cannot complete a
+ * transmission, the policy decides which ones are sent
+ */
+ZTEST(uart_router, test_overflow)
+{
+	struct uart_router_port_stats before = stats(PAIR_A);
+	struct uart_router_port_stats after;
+	static char expected[BURST_LINES * 16];
+	char line[16];
+	size_t len = 0;
+
+	/* The emulator completes transmissions from a work queue, which
+	 * cannot run before the burst is queued. With flow control the
+	 * sender blocks, and the work queue runs meanwhile.
+	 */
+	k_sched_lock();
+	for (unsigned int i = 0; i < BURST_LINES; i++) {
+		snprintf(line, sizeof(line), "line %u\r\n", i);
+		zassert_ok(uart_router_send(PAIR_A, line));
+	}
+	k_sched_unlock();
+
+	k_sleep(SETTLE);
+	after = stats(PAIR_A);
+
+	for (unsigned int i = 0; i < BURST_LINES; i++) {
+		/* The first line is in transmission, the next TX_QUEUE_LEN
+		 * ones fill the queue
+		 */
+		bool sent = IS_ENABLED(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL) ||
+			    (IS_ENABLED(CONFIG_UART_ROUTER_OVERFLOW_DROP_NEWEST) &&
+			     (i <= TX_QUEUE_LEN)) ||
+			    (IS_ENABLED(CONFIG_UART_ROUTER_OVERFLOW_DROP_OLDEST) &&
+			     ((i == 0) || (i >= BURST_LINES - TX_QUEUE_LEN)));
+
+		if (sent) {
+			len += snprintf(&expected[len], sizeof(expected) - len, "line %u\r\n", i);
+		}
+	}
+
+	tx_expect(PAIR_A, expected);
+	zassert_equal(after.tx_queue_high_water, TX_QUEUE_LEN);
+
+	if (IS_ENABLED(CONFIG_UART_ROUTER_OVERFLOW_FLOW_CONTROL)) {
+		zassert_equal(after.tx_drop_lines, before.tx_drop_lines);
+	} else {
+		zassert_equal(after.tx_drop_lines - before.tx_drop_lines,
+			      BURST_LINES - TX_QUEUE_LEN - 1);
+		zassert_equal(after.tx_drop_bytes - before.tx_drop_bytes,
+			      (BURST_LINES - TX_QUEUE_LEN - 1) * strlen("line 0\r\n"));
+	}
+}
+
+/* Emulated time from the first byte received to the last byte sent, the
+ * figures are for comparing changes to the router, not real UARTs
+ */
+ZTEST(uart_router, test_throughput)
+{
+	static const char payload[] = "0123456789abcdefghijklmnopqrstu\n";
+	const size_t line_len = strlen("From Uart0: ") + strlen(payload) + 1;
+	struct uart_router_port_stats before = stats(PAIR_A);
+	uint32_t tx_drop_lines = stats(PAIR_B).tx_drop_lines;
+	struct uart_router_port_stats after;
+	uint32_t lines = 0;
+	int64_t start = k_uptime_get();
+	int64_t elapsed_ms;
+
+	BUILD_ASSERT(sizeof(payload) - 2 <= CONFIG_UART_ROUTER_LINE_SIZE);
+
+	while (lines < THROUGHPUT_LINES) {
+		size_t expected = 0;
+		size_t received = 0;
+
+		for (size_t i = 0; i < THROUGHPUT_BURST; i++) {
+			rx_feed(PAIR_A, payload);
+			expected += line_len;
+		}
+
+		for (int64_t timeout = k_uptime_get() + 1000; received < expected;) {
+			zassert_true(k_uptime_get() < timeout, "%zu of %zu bytes routed", received,
+				     expected);
+			k_sleep(K_TICKS(1));
+			received += strlen(tx_take(PAIR_B));
+		}
+		zassert_equal(received, expected);
+
+		lines += THROUGHPUT_BURST;
+	}
+
+	elapsed_ms = MAX(k_uptime_get() - start, 1);
+	after = stats(PAIR_A);
+
+	zassert_equal(after.rx_lines - before.rx_lines, THROUGHPUT_LINES);
+	zassert_equal(after.rx_pool_drop_bytes, before.rx_pool_drop_bytes);
+	zassert_equal(stats(PAIR_B).tx_drop_lines, tx_drop_lines);
+
+	TC_PRINT("%u lines in %lld ms: %lld lines/s, %lld B/s, line pool high water %u/%u\n",
+		 lines, elapsed_ms, (lines * MSEC_PER_SEC) / elapsed_ms,
+		 (lines * line_len * MSEC_PER_SEC) / elapsed_ms, uart_router_pool_high_water(),
+		 CONFIG_UART_ROUTER_LINE_COUNT);
+}
+
+ZTEST_SUITE(uart_router, NULL, router_setup, router_before, NULL, NULL);
@@ -0,0 +1,145 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+
+#include <uart_rx.h>
+
+/* 1 Mbaud with 8N1 framing, fed in one block per tick */
+#define BYTES_PER_SEC 100000
+#define BYTES_PER_TICK (BYTES_PER_SEC / CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+BUILD_ASSERT(BYTES_PER_TICK <= DT_PROP(DT_NODELABEL(euart0), rx_fifo_size));
+
+#define STREAM_BYTES (2 * BYTES_PER_SEC)
+
+/* More than the chunk pool and the DMA buffers hold together */
+#define STALL_BYTES (2 * CONFIG_BT_NUS_UART_RX_DATA_COUNT * CONFIG_BT_NUS_UART_BUFFER_SIZE)
+#define RESUME_BYTES 1000
+
+/* Longer than the RX idle timeout and the emulator work items */
+#define SETTLE K_MSEC(50)
+
+/* Prime, so a dropped block never lines up with the pattern */
+#define PATTERN_MOD 251
+
+static const struct device *const uart = DEVICE_DT_GET(DT_NODELABEL(euart0));
+
+static uint8_t tx_pattern_next;
+
+/* Taken by the test to stall the consumer, like a slow BLE link */
+static K_SEM_DEFINE(consumer_gate, 1, 1);
+static uint8_t rx_expected;
+/* The next byte starts a new sequence and is not checked */
+static bool rx_resync = true;
+static size_t rx_total;
+static size_t rx_gaps;
+
+static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+
+	uart_rx_event(evt);
+}
+
+/* Stands in for the BLE write thread of the sample */
+static void consumer(void)
+{
+	for (;;) {
+		struct uart_data_t *buf = uart_rx_get(K_FOREVER);
+
+		k_sem_take(&consumer_gate, K_FOREVER);
+
+		for (size_t i = 0; i < buf->len; i++) {
+			if (!rx_resync && (buf->data[i] != rx_expected)) {
+				rx_gaps++;
+			}
+			rx_resync = false;
+			rx_expected = (buf->data[i] + 1) % PATTERN_MOD;
+		}
+		rx_total += buf->len;
+
+		k_sem_give(&consumer_gate);
+		uart_rx_free(buf);
+	}
+}
+
+K_THREAD_DEFINE(consumer_id, 1024, consumer, NULL, NULL, NULL, 7, 0, 0);
+
+/* Feed len bytes of the pattern at 1 Mbaud */
+static void rx_feed(size_t len)
+{
+	uint8_t block[BYTES_PER_TICK];
+
+	while (len) {
+		size_t n = MIN(len, sizeof(block));
+
+		for (size_t i = 0; i < n; i++) {
+			block[i] = tx_pattern_next;
+			tx_pattern_next = (tx_pattern_next + 1) % PATTERN_MOD;
+		}
+		zassert_equal(uart_emul_put_rx_data(uart, block, n), n, "UART FIFO overrun");
+		k_sleep(K_TICKS(1));
+		len -= n;
+	}
+}
+
+static void *uart_rx_setup(void)
+{
+	zassert_true(device_is_ready(uart));
+	zassert_ok(uart_callback_set(uart, uart_cb, NULL));
+	zassert_ok(uart_rx_start(uart));
+
+	return NULL;
+}
+
+static void uart_rx_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	k_sleep(SETTLE);
+	rx_resync = true;
+	rx_total = 0;
+	rx_gaps = 0;
+}
+
+/* Sustained input at 1 Mbaud arrives complete and in order */
+ZTEST(uart_rx, test_stream)
+{
+	rx_feed(STREAM_BYTES);
+	k_sleep(SETTLE);
+
+	zassert_equal(rx_total, STREAM_BYTES, "%zu of %d bytes received", rx_total,
+		      STREAM_BYTES);
+	zassert_equal(rx_gaps, 0);
+}
+
+/* Data received while the consumer stalls and the pool is exhausted is
+ * dropped, reception itself keeps running
+ */
+ZTEST(uart_rx, test_stall)
+{
+	size_t stalled;
+
+	k_sem_take(&consumer_gate, K_FOREVER);
+	rx_feed(STALL_BYTES);
+	k_sem_give(&consumer_gate);
+	k_sleep(SETTLE);
+
+	stalled = rx_total;
+	zassert_true(stalled < STALL_BYTES, "Nothing dropped");
+
+	rx_resync = true;
+	rx_gaps = 0;
+	rx_feed(RESUME_BYTES);
+	k_sleep(SETTLE);
+
+	zassert_equal(rx_total - stalled, RESUME_BYTES);
+	zassert_equal(rx_gaps, 0);
+}
+
+ZTEST_SUITE(uart_rx, NULL, uart_rx_setup, uart_rx_before, NULL, NULL);
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "jitter_report.h"
+
+#include <string.h>
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(jitter_report, LOG_LEVEL_INF);
+
+/* 62.5 ns per timestamp tick */
+#define TICKS_TO_NS(_ticks) \
+	((int32_t)((int64_t)(_ticks) * NSEC_PER_SEC / SPIM_SAMPLER_TIMESTAMP_HZ))
+
+static uint32_t isqrt(uint64_t val)
+{
+	uint64_t res = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > val) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (val >= (res + bit)) {
+			val -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint32_t)res;
+}
+
+static void stat_add(struct jitter_stat *stat, int32_t val)
+{
+	if (!stat->count) {
+		stat->min = val;
+		stat->max = val;
+	}
+
+	stat->count++;
+	stat->min = MIN(stat->min, val);
+	stat->max = MAX(stat->max, val);
+	stat->sum += val;
+	stat->sum_sq += (int64_t)val * val;
+}
+
+static void stat_log(const char *name, const struct jitter_stat *stat)
+{
+	if (!stat->count) {
+		LOG_INF("%s: no data", name);
+		return;
+	}
+
+	/* Stddev in ticks scaled by count, to keep the division at the end */
+	int64_t mean = stat->sum / stat->count;
+	uint64_t var = (stat->sum_sq * stat->count) - (uint64_t)(stat->sum * stat->sum);
+	uint32_t stddev = isqrt(var) / stat->count;
+
+	LOG_INF("%s: min %d max %d mean %d stddev %d ns (%u blocks)", name,
+		TICKS_TO_NS(stat->min), TICKS_TO_NS(stat->max),
+		TICKS_TO_NS(mean), TICKS_TO_NS(stddev), stat->count);
+}
+
+void jitter_report_reset(struct jitter_report *report)
+{
+	/* The last block is kept so the next interval is still measured */
+	memset(&report->interval_err, 0, sizeof(report->interval_err));
+	memset(&report->xfer_time, 0, sizeof(report->xfer_time));
+	report->gaps = 0;
+}
+
+void jitter_report_add(struct jitter_report *report,
+		       const struct spim_sampler_block *block)
+{
+	/* Both timestamps come from the same free running timer, unsigned
+	 * differences stay correct across its wrap.
+	 */
+	stat_add(&report->xfer_time, block->end_timestamp - block->timestamp);
+
+	if (report->has_last && (block->seq == (report->last_seq + 1))) {
+		uint32_t interval = block->timestamp - report->last_timestamp;
+		uint32_t nominal = block->samples * block->period_ticks;
+
+		stat_add(&report->interval_err, (int32_t)(interval - nominal));
+	} else if (report->has_last) {
+		/* A dropped block says nothing about the timing */
+		report->gaps++;
+	}
+
+	report->last_timestamp = block->timestamp;
+	report->last_seq = block->seq;
+	report->has_last = true;
+}
+
+void jitter_report_log(const struct jitter_report *report)
+{
+	stat_log("Block interval error", &report->interval_err);
+	stat_log("Transfer time", &report->xfer_time);
+	if (report->gaps) {
+		LOG_INF("Sequence gaps: %u", report->gaps);
+	}
+}
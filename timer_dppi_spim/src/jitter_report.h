@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef JITTER_REPORT_H_
+#define JITTER_REPORT_H_
+
+#include <zephyr.h>
+
+#include "spim_sampler.h"
+
+/*
+ * Timing statistics built from the hardware block timestamps.
+ *
+ * The interval error is the distance between the last transfers of two
+ * consecutive blocks minus the nominal block period. As transfers are
+ * started by the sample timer this shows the accuracy of the whole
+ * pipeline; any non zero value means transfers were skipped or restarted.
+ * The transfer time is START to END of the last transfer in each block.
+ */
+
+struct jitter_stat {
+	uint32_t count;
+	int32_t min;
+	int32_t max;
+	int64_t sum;
+	uint64_t sum_sq;
+};
+
+struct jitter_report {
+	struct jitter_stat interval_err;
+	struct jitter_stat xfer_time;
+	uint32_t last_timestamp;
+	uint32_t last_seq;
+	uint32_t gaps;
+	bool has_last;
+};
+
+/* Clear the statistics, the last block seen is kept */
+void jitter_report_reset(struct jitter_report *report);
+
+/* Account for one block, call for every block in sequence order */
+void jitter_report_add(struct jitter_report *report,
+		       const struct spim_sampler_block *block);
+
+/* Log the statistics in ns */
+void jitter_report_log(const struct jitter_report *report);
+
+#endif /* JITTER_REPORT_H_ */
@@ -7,126 +7,179 @@
 #include <zephyr.h>
 #include <devicetree.h>
 
-#include <nrfx_timer.h>
-#include <nrfx_dppi.h>
-#include <helpers/nrfx_gppi.h>
-#include <nrfx_spim.h>
-
 #include <logging/log.h>
 LOG_MODULE_REGISTER(timer_dppi_spim, LOG_LEVEL_INF);
 
-static const nrfx_timer_t m_sample_timer = NRFX_TIMER_INSTANCE(1);
+#include "spim_sampler.h"
+#include "jitter_report.h"
+#ifdef CONFIG_DEMO_TWIM_BATCH
+#include "twim_batch.h"
+#endif
 
-#define BUF_SIZE 10
-uint8_t buffer_tx[BUF_SIZE] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
-uint8_t buffer_rx[BUF_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+#define SAMPLE_SIZE 10
 
-nrfx_spim_xfer_desc_t transfer = {
-	.p_tx_buffer = buffer_tx, ///< Pointer to TX buffer.
-	.tx_length = BUF_SIZE, ///< TX buffer length.
-	.p_rx_buffer = buffer_rx, ///< Pointer to RX buffer.
-	.rx_length = BUF_SIZE ///< RX buffer length.
-};
+/* Read by EasyDMA, so it has to be in RAM */
+static uint8_t buffer_tx[SAMPLE_SIZE] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+
+SPIM_SAMPLER_RING_DEFINE(sample_ring, SAMPLE_SIZE, CONFIG_DEMO_BLOCK_SAMPLES,
+			 CONFIG_DEMO_BLOCK_COUNT);
+
+static struct spim_sampler sampler;
 
-nrfx_spim_t spi_instance = NRFX_SPIM_INSTANCE(2);
-nrfx_spim_config_t spi_config =
-	NRFX_SPIM_DEFAULT_CONFIG(28, 29, 30, NRFX_SPIM_PIN_NOT_USED);
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+static struct jitter_report jitter;
 
-void timer_handler(nrf_timer_event_t event_type, void* p_context)
+static void jitter_update(const struct spim_sampler_block *block)
 {
-	LOG_DBG("Timer Handler.");
+	jitter_report_add(&jitter, block);
 
+	if (jitter.xfer_time.count >= CONFIG_DEMO_JITTER_REPORT_BLOCKS) {
+		LOG_INF("First sample of block %u started at %u ticks", block->seq,
+			spim_sampler_sample_time(block, 0));
+		jitter_report_log(&jitter);
+		jitter_report_reset(&jitter);
+	}
 }
-
-static void timer_init(void)
+#else
+static void jitter_update(const struct spim_sampler_block *block)
 {
-    nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
-	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
-    nrfx_err_t err_code = nrfx_timer_init(&m_sample_timer, &timer_config, timer_handler);
-    if (err_code != NRFX_SUCCESS) {
-        LOG_ERR("nrfx_timer_init error: %08x", err_code);
-        return;
-    }
-    nrfx_timer_extended_compare(&m_sample_timer,
-                                NRF_TIMER_CC_CHANNEL0,
-                                nrfx_timer_us_to_ticks(&m_sample_timer, 500),
-                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK,
-                                true);
-    
-    LOG_INF("Timer 1 initialized.");
-    nrfx_timer_enable(&m_sample_timer);
-
-	
-    IRQ_CONNECT(TIMER1_IRQn, 0,
-         nrfx_timer_1_irq_handler, NULL, 0);
 }
+#endif
 
-static void spim_handler(nrfx_spim_evt_t const *p_event, void *p_context)
+static void block_handler(struct spim_sampler *s, const struct spim_sampler_block *block,
+			  void *user_data)
 {
-	if (p_event->type == NRFX_SPIM_EVENT_DONE) {
-		LOG_INF("SPI transfer finished");
+	uint8_t min = UINT8_MAX;
+	uint8_t max = 0;
+
+	/* Stand-in for real processing: range of the first byte of each sample */
+	for (size_t i = 0; i < block->samples; i++) {
+		uint8_t val = block->data[i * block->sample_size];
+
+		min = MIN(min, val);
+		max = MAX(max, val);
 	}
+
+	LOG_INF("Block %u: %u samples, min %u max %u, dropped %u",
+		block->seq, block->samples, min, max, spim_sampler_dropped_get(s));
+
+	struct spim_sampler_metrics metrics;
+
+	spim_sampler_metrics_get(s, &metrics);
+	LOG_INF("%u samples/s, %u wakeups/s, ~%u uA saved",
+		metrics.samples_per_sec, metrics.wakeups_per_sec,
+		metrics.saved_current_ua);
+
+	jitter_update(block);
 }
 
-static void spi_init(void)
-{
-	nrfx_err_t err_code;
-	
-	spi_config.frequency = NRF_SPIM_FREQ_1M;
+#ifdef CONFIG_DEMO_TWIM_BATCH
+static struct twim_batch_queue twim_queue;
 
-	IRQ_CONNECT(SPIM2_SPIS2_TWIM2_TWIS2_UARTE2_IRQn, 5, nrfx_isr,
-		    nrfx_spim_2_irq_handler, 0);
+/* BME680 chip ID and field 0 pressure, temperature and humidity. The
+ * three data reads are consecutive registers and share one transfer.
+ */
+static struct twim_batch_read bme680_reads[] = {
+	{ .addr = CONFIG_DEMO_TWIM_ADDR, .reg = 0xD0, .len = 1 },
+	{ .addr = CONFIG_DEMO_TWIM_ADDR, .reg = 0x1F, .len = 3 },
+	{ .addr = CONFIG_DEMO_TWIM_ADDR, .reg = 0x22, .len = 3 },
+	{ .addr = CONFIG_DEMO_TWIM_ADDR, .reg = 0x25, .len = 2 },
+};
 
-	err_code = nrfx_spim_init(&spi_instance, &spi_config, spim_handler, NULL);
+static void batch_handler(struct twim_batch *batch, int err, void *user_data)
+{
+	struct twim_batch_stats stats;
 
-	if (err_code != NRFX_SUCCESS) {
-		LOG_ERR("nrfx_spim_init error: %08x", err_code);
+	/* One line per second */
+	if (batch->seq % MAX(1, MSEC_PER_SEC / CONFIG_DEMO_TWIM_PERIOD_MS)) {
 		return;
 	}
 
-	err_code = nrfx_spim_xfer(&spi_instance, &transfer, 0);
-	if (err_code != NRFX_SUCCESS) {
-		LOG_ERR("SPI transfer error: %08x", err_code);
-		return;
+	if (err) {
+		LOG_WRN("Batch %u failed (err %d)", batch->seq, err);
+	} else {
+		LOG_INF("Batch %u: chip id 0x%02x, temp raw 0x%02x%02x", batch->seq,
+			bme680_reads[0].data[0], bme680_reads[2].data[0],
+			bme680_reads[2].data[1]);
 	}
 
+	twim_batch_stats_get(&twim_queue, &stats);
+	LOG_INF("%u batches, %u transfers, %u reads merged, %u errors, %u overruns",
+		stats.batches, stats.transfers, stats.merged, stats.errors,
+		stats.overruns);
 }
 
-static void dppi_init(void)
+static struct twim_batch bme680_batch = {
+	.reads = bme680_reads,
+	.read_count = ARRAY_SIZE(bme680_reads),
+	.cb = batch_handler,
+};
+
+static void twim_demo_start(void)
 {
-	uint8_t dppi_ch_1;
-	nrfx_err_t err = nrfx_dppi_channel_alloc(&dppi_ch_1);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("Err %d", err);
+	int err;
+	struct twim_batch_queue_config config = {
+		.twim = NRFX_TWIM_INSTANCE(1),
+		.twim_config = NRFX_TWIM_DEFAULT_CONFIG(CONFIG_DEMO_TWIM_SCL_PIN,
+							CONFIG_DEMO_TWIM_SDA_PIN),
+	};
+
+	config.twim_config.frequency = NRF_TWIM_FREQ_400K;
+
+	err = twim_batch_queue_init(&twim_queue, &config);
+	if (err) {
+		LOG_ERR("Failed to initialize TWIM queue (err %d)", err);
 		return;
 	}
 
-	err = nrfx_dppi_channel_enable(dppi_ch_1);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("Err %d", err);
+	err = twim_batch_prepare(&bme680_batch);
+	if (err) {
+		LOG_ERR("Failed to prepare batch (err %d)", err);
 		return;
 	}
 
-	nrfx_gppi_channel_endpoints_setup(dppi_ch_1,
-			nrf_timer_event_address_get(m_sample_timer.p_reg,
-				NRF_TIMER_EVENT_COMPARE0),
-			nrf_spim_task_address_get(NRF_SPIM2,
-				NRF_SPIM_TASK_START));
-
-
-	/* Tie it all together */
-	nrf_timer_publish_set(m_sample_timer.p_reg, NRF_TIMER_EVENT_COMPARE0, dppi_ch_1);
-	nrf_spim_subscribe_set(spi_instance.p_reg, NRF_SPIM_TASK_START, dppi_ch_1);
+	err = twim_batch_periodic_start(&twim_queue, &bme680_batch,
+					CONFIG_DEMO_TWIM_PERIOD_MS * USEC_PER_MSEC);
+	if (err) {
+		LOG_ERR("Failed to start batch (err %d)", err);
+	}
 }
-
-void main(void)
+#else
+static void twim_demo_start(void)
 {
-    LOG_INF("Timer + DPPI + SPIM Application...");
-	timer_init();
-	spi_init();
-	dppi_init(); 
 }
+#endif /* CONFIG_DEMO_TWIM_BATCH */
 
+void main(void)
+{
+	int err;
+	struct spim_sampler_config config = {
+		.spim = NRFX_SPIM_INSTANCE(2),
+		.spim_config = NRFX_SPIM_DEFAULT_CONFIG(28, 29, 30, NRFX_SPIM_PIN_NOT_USED),
+		.tx_buf = buffer_tx,
+		.tx_len = sizeof(buffer_tx),
+		.sample_size = SAMPLE_SIZE,
+		.sample_rate_hz = CONFIG_DEMO_SAMPLE_RATE_HZ,
+		.block_samples = CONFIG_DEMO_BLOCK_SAMPLES,
+		.ring = sample_ring,
+		.ring_size = sizeof(sample_ring),
+		.cb = block_handler,
+	};
+
+	LOG_INF("Timer + DPPI + SPIM Application...");
+
+	config.spim_config.frequency = NRF_SPIM_FREQ_1M;
+
+	err = spim_sampler_init(&sampler, &config);
+	if (err) {
+		LOG_ERR("Failed to initialize sampler (err %d)", err);
+		return;
+	}
 
+	err = spim_sampler_start(&sampler);
+	if (err) {
+		LOG_ERR("Failed to start sampler (err %d)", err);
+	}
 
-
+	twim_demo_start();
+}
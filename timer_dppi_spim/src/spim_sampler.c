@@ -0,0 +1,648 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+
+#include <nrfx_timer.h>
+#include <nrfx_spim.h>
+
+#include <string.h>
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(spim_sampler, LOG_LEVEL_INF);
+
+#include "spim_sampler.h"
+#include "timer_pool.h"
+
+#define IRQ_PRIO CONFIG_SPIM_SAMPLER_IRQ_PRIORITY
+
+/* Graph links, the START link is gated by the group */
+#define LINK_START 0
+#define LINK_COUNT 1
+#define LINK_GATE 2
+#define START_GROUP 0
+
+struct block_msg {
+	struct spim_sampler *sampler;
+	uint32_t generation;
+	uint16_t index;
+	uint32_t seq;
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+	uint32_t timestamp;
+	uint32_t end_timestamp;
+#endif
+};
+
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+/* Free running timer shared by all samplers, CC channels are claimed */
+static const nrfx_timer_t *ts_timer;
+static uint32_t ts_cc_used;
+#endif
+
+K_MSGQ_DEFINE(block_msgq, sizeof(struct block_msg), CONFIG_SPIM_SAMPLER_QUEUE_SIZE, 4);
+/* Held by the consumer while it handles a block */
+static K_MUTEX_DEFINE(consumer_lock);
+
+static void irq_connect_all(void)
+{
+	static bool connected;
+
+	if (connected) {
+		return;
+	}
+	connected = true;
+
+	/* IRQ_CONNECT needs build time constants, so every instance that
+	 * may be used is connected up front. TIMERs are connected by the pool.
+	 */
+#ifdef CONFIG_NRFX_SPIM0
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_SPIM0), IRQ_PRIO, nrfx_isr,
+		    nrfx_spim_0_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_SPIM1
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_SPIM1), IRQ_PRIO, nrfx_isr,
+		    nrfx_spim_1_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_SPIM2
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_SPIM2), IRQ_PRIO, nrfx_isr,
+		    nrfx_spim_2_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_SPIM3
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_SPIM3), IRQ_PRIO, nrfx_isr,
+		    nrfx_spim_3_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_SPIM4
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_SPIM4), IRQ_PRIO, nrfx_isr,
+		    nrfx_spim_4_irq_handler, 0);
+#endif
+}
+
+static void timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+	/* Nothing here due to DPPI */
+}
+
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+static int ts_timer_init(void)
+{
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+
+	if (ts_timer) {
+		return 0;
+	}
+
+	ts_timer = timer_pool_claim();
+	if (!ts_timer) {
+		LOG_ERR("No free TIMER instance for timestamps");
+		return -EBUSY;
+	}
+
+	timer_config.frequency = NRF_TIMER_FREQ_16MHz;
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	nrfx_err_t err_code = nrfx_timer_init(ts_timer, &timer_config, timer_handler);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_timer_init error: %08x", err_code);
+		timer_pool_release(ts_timer);
+		ts_timer = NULL;
+		return -EIO;
+	}
+
+	/* Never cleared, it wraps every 268 s which unsigned math absorbs */
+	nrfx_timer_enable(ts_timer);
+
+	return 0;
+}
+
+static int ts_cc_claim(uint8_t *cc)
+{
+	unsigned int key = irq_lock();
+	int err = -EBUSY;
+
+	for (uint8_t i = 0; i < ts_timer->cc_channel_count; i++) {
+		if (!(ts_cc_used & BIT(i))) {
+			ts_cc_used |= BIT(i);
+			*cc = i;
+			err = 0;
+			break;
+		}
+	}
+
+	irq_unlock(key);
+	return err;
+}
+
+static void ts_cc_release(uint8_t cc)
+{
+	unsigned int key = irq_lock();
+
+	ts_cc_used &= ~BIT(cc);
+	irq_unlock(key);
+}
+
+static uint32_t ts_capture_tep(uint8_t cc)
+{
+	return nrf_timer_task_address_get(ts_timer->p_reg, nrf_timer_capture_task_get(cc));
+}
+#endif /* CONFIG_SPIM_SAMPLER_TIMESTAMP */
+
+static void count_timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+	struct spim_sampler *sampler = p_context;
+	struct block_msg msg = {
+		.sampler = sampler,
+		.generation = sampler->generation,
+		.index = sampler->block_index,
+		.seq = sampler->block_seq++,
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+		/* Captured by DPPI, the next transfer is a full period away */
+		.timestamp = nrfx_timer_capture_get(ts_timer, sampler->ts_cc_start),
+		.end_timestamp = nrfx_timer_capture_get(ts_timer, sampler->ts_cc_end),
+#endif
+	};
+
+	sampler->wakeups++;
+
+	/* The end of the block closed the START gate in hardware, so RXD.PTR
+	 * cannot move on past the ring however late this runs. A late
+	 * interrupt costs the samples between this block and the next one.
+	 */
+	if (++sampler->block_index == sampler->block_count) {
+		/* Wrap the ArrayList back to the start of the ring */
+		nrf_spim_rx_buffer_set(sampler->cfg.spim.p_reg, sampler->cfg.ring,
+				       sampler->cfg.sample_size);
+		sampler->block_index = 0;
+	}
+
+	gppi_graph_group_enable(&sampler->graph, START_GROUP);
+
+	if (k_msgq_put(&block_msgq, &msg, K_NO_WAIT)) {
+		sampler->blocks_dropped++;
+	}
+}
+
+static void spim_handler(nrfx_spim_evt_t const *p_event, void *p_context)
+{
+	/* Not called, END is counted by the count timer instead of interrupting */
+}
+
+static int sample_timer_init(struct spim_sampler *sampler)
+{
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	timer_config.p_context = sampler;
+	nrfx_err_t err_code = nrfx_timer_init(sampler->sample_timer, &timer_config,
+					      timer_handler);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_timer_init error: %08x", err_code);
+		return -EIO;
+	}
+
+	return spim_sampler_rate_set(sampler, sampler->cfg.sample_rate_hz);
+}
+
+static int count_timer_init(struct spim_sampler *sampler)
+{
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+
+	timer_config.mode = NRF_TIMER_MODE_LOW_POWER_COUNTER;
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	timer_config.p_context = sampler;
+	nrfx_err_t err_code = nrfx_timer_init(sampler->count_timer, &timer_config,
+					      count_timer_handler);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_timer_init error: %08x", err_code);
+		return -EIO;
+	}
+
+	/* Interrupt once per block, the counter restarts by itself */
+	nrfx_timer_extended_compare(sampler->count_timer,
+				    NRF_TIMER_CC_CHANNEL0,
+				    sampler->cfg.block_samples,
+				    NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK,
+				    true);
+
+	return 0;
+}
+
+static int spi_init(struct spim_sampler *sampler)
+{
+	nrfx_err_t err_code;
+
+	err_code = nrfx_spim_init(&sampler->cfg.spim, &sampler->cfg.spim_config,
+				  spim_handler, sampler);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_spim_init error: %08x", err_code);
+		return -EIO;
+	}
+
+	sampler->transfer = (nrfx_spim_xfer_desc_t) {
+		.p_tx_buffer = sampler->cfg.tx_buf,
+		.tx_length = sampler->cfg.tx_len,
+		.p_rx_buffer = sampler->cfg.ring,
+		.rx_length = sampler->cfg.sample_size,
+	};
+
+	/* Only set up the transfer, every START comes from the sample timer.
+	 * EasyDMA ArrayList: RXD.PTR advances by one sample after every
+	 * transfer, so the samples of a block land back to back in the ring.
+	 */
+	err_code = nrfx_spim_xfer(&sampler->cfg.spim, &sampler->transfer,
+				  NRFX_SPIM_FLAG_HOLD_XFER |
+				  NRFX_SPIM_FLAG_REPEATED_XFER |
+				  NRFX_SPIM_FLAG_RX_POSTINC |
+				  NRFX_SPIM_FLAG_NO_XFER_EVT_HANDLER);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("SPI transfer error: %08x", err_code);
+		nrfx_spim_uninit(&sampler->cfg.spim);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static uint32_t start_eep(const struct spim_sampler *sampler)
+{
+	return nrf_timer_event_address_get(sampler->sample_timer->p_reg,
+					   NRF_TIMER_EVENT_COMPARE0);
+}
+
+static uint32_t start_tep(const struct spim_sampler *sampler)
+{
+	return nrf_spim_task_address_get(sampler->cfg.spim.p_reg, NRF_SPIM_TASK_START);
+}
+
+static uint32_t count_eep(const struct spim_sampler *sampler)
+{
+	return nrf_spim_event_address_get(sampler->cfg.spim.p_reg, NRF_SPIM_EVENT_END);
+}
+
+static uint32_t count_tep(const struct spim_sampler *sampler)
+{
+	return nrf_timer_task_address_get(sampler->count_timer->p_reg,
+					  NRF_TIMER_TASK_COUNT);
+}
+
+static uint32_t block_eep(const struct spim_sampler *sampler)
+{
+	return nrf_timer_event_address_get(sampler->count_timer->p_reg,
+					   NRF_TIMER_EVENT_COMPARE0);
+}
+
+static int dppi_init(struct spim_sampler *sampler)
+{
+	const struct gppi_graph_link links[] = {
+		[LINK_START] = {
+			/* Timer compare starts a transfer */
+			.eep = start_eep(sampler),
+			.tep = start_tep(sampler),
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+			.fork_tep = ts_capture_tep(sampler->ts_cc_start),
+#endif
+			.group = START_GROUP,
+		},
+		[LINK_COUNT] = {
+			/* Every finished transfer bumps the block counter */
+			.eep = count_eep(sampler),
+			.tep = count_tep(sampler),
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+			.fork_tep = ts_capture_tep(sampler->ts_cc_end),
+#endif
+			.group = GPPI_GRAPH_NO_GROUP,
+		},
+		[LINK_GATE] = {
+			/* A full block holds off further transfers until the
+			 * interrupt has moved RXD.PTR on
+			 */
+			.eep = block_eep(sampler),
+			.tep = GPPI_GRAPH_TEP_GROUP_DIS(START_GROUP),
+			.group = GPPI_GRAPH_NO_GROUP,
+		},
+	};
+	const struct gppi_graph_desc desc = {
+		.links = links,
+		.link_count = ARRAY_SIZE(links),
+		.group_count = 1,
+	};
+
+	return gppi_graph_setup(&sampler->graph, &desc);
+}
+
+static void dppi_deinit(struct spim_sampler *sampler)
+{
+	gppi_graph_teardown(&sampler->graph);
+}
+
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+static int ts_init(struct spim_sampler *sampler)
+{
+	int err;
+
+	err = ts_timer_init();
+	if (err) {
+		return err;
+	}
+
+	err = ts_cc_claim(&sampler->ts_cc_start);
+	if (err) {
+		LOG_ERR("No free timestamp CC channel");
+		return err;
+	}
+
+	err = ts_cc_claim(&sampler->ts_cc_end);
+	if (err) {
+		LOG_ERR("No free timestamp CC channel");
+		ts_cc_release(sampler->ts_cc_start);
+		return err;
+	}
+
+	return 0;
+}
+
+static void ts_deinit(struct spim_sampler *sampler)
+{
+	ts_cc_release(sampler->ts_cc_end);
+	ts_cc_release(sampler->ts_cc_start);
+}
+#else
+static int ts_init(struct spim_sampler *sampler)
+{
+	return 0;
+}
+
+static void ts_deinit(struct spim_sampler *sampler)
+{
+}
+#endif /* CONFIG_SPIM_SAMPLER_TIMESTAMP */
+
+static int config_check(const struct spim_sampler_config *config)
+{
+	size_t block_size = config->sample_size * config->block_samples;
+
+	if (!config->sample_size || !config->block_samples || !config->sample_rate_hz ||
+	    !config->ring || !config->cb) {
+		return -EINVAL;
+	}
+
+	/* EasyDMA only reaches RAM */
+	if ((config->tx_len && !nrfx_is_in_ram(config->tx_buf)) ||
+	    !nrfx_is_in_ram(config->ring)) {
+		return -EINVAL;
+	}
+
+	/* The ring has to hold at least two whole blocks */
+	if ((config->ring_size % block_size) || ((config->ring_size / block_size) < 2)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int spim_sampler_init(struct spim_sampler *sampler,
+		      const struct spim_sampler_config *config)
+{
+	int err;
+
+	err = config_check(config);
+	if (err) {
+		LOG_ERR("Invalid sampler configuration");
+		return err;
+	}
+
+	uint32_t generation = sampler->generation;
+
+	memset(sampler, 0, sizeof(*sampler));
+	/* Kept across a deinit and init, blocks queued before still differ */
+	sampler->generation = generation;
+	sampler->cfg = *config;
+	sampler->block_count = config->ring_size /
+			       (config->sample_size * config->block_samples);
+
+	irq_connect_all();
+
+	err = ts_init(sampler);
+	if (err) {
+		return err;
+	}
+
+	sampler->sample_timer = timer_pool_claim();
+	sampler->count_timer = timer_pool_claim();
+	if (!sampler->sample_timer || !sampler->count_timer) {
+		LOG_ERR("No free TIMER instance");
+		err = -EBUSY;
+		goto release_timers;
+	}
+
+	err = sample_timer_init(sampler);
+	if (err) {
+		goto release_timers;
+	}
+
+	err = count_timer_init(sampler);
+	if (err) {
+		goto uninit_sample_timer;
+	}
+
+	err = spi_init(sampler);
+	if (err) {
+		goto uninit_count_timer;
+	}
+
+	err = dppi_init(sampler);
+	if (err) {
+		goto uninit_spi;
+	}
+
+	LOG_INF("Sampler on SPIM%u: %u Hz, %u blocks of %u samples",
+		sampler->cfg.spim.drv_inst_idx, config->sample_rate_hz,
+		sampler->block_count, config->block_samples);
+
+	return 0;
+
+uninit_spi:
+	nrfx_spim_uninit(&sampler->cfg.spim);
+uninit_count_timer:
+	nrfx_timer_uninit(sampler->count_timer);
+uninit_sample_timer:
+	nrfx_timer_uninit(sampler->sample_timer);
+release_timers:
+	if (sampler->sample_timer) {
+		timer_pool_release(sampler->sample_timer);
+	}
+	if (sampler->count_timer) {
+		timer_pool_release(sampler->count_timer);
+	}
+	ts_deinit(sampler);
+	return err;
+}
+
+int spim_sampler_start(struct spim_sampler *sampler)
+{
+	if (sampler->running) {
+		return -EALREADY;
+	}
+
+	sampler->running = true;
+	nrfx_timer_enable(sampler->count_timer);
+	nrfx_timer_enable(sampler->sample_timer);
+
+	return 0;
+}
+
+int spim_sampler_deinit(struct spim_sampler *sampler)
+{
+	nrfx_timer_disable(sampler->sample_timer);
+	nrfx_timer_disable(sampler->count_timer);
+	sampler->running = false;
+
+	dppi_deinit(sampler);
+
+	nrfx_spim_uninit(&sampler->cfg.spim);
+	nrfx_timer_uninit(sampler->count_timer);
+	nrfx_timer_uninit(sampler->sample_timer);
+	timer_pool_release(sampler->count_timer);
+	timer_pool_release(sampler->sample_timer);
+	ts_deinit(sampler);
+
+	/* Waits for a callback in progress, the blocks still queued for this
+	 * sampler then carry an old generation and are skipped
+	 */
+	k_mutex_lock(&consumer_lock, K_FOREVER);
+	sampler->generation++;
+	k_mutex_unlock(&consumer_lock);
+
+	return 0;
+}
+
+int spim_sampler_rate_set(struct spim_sampler *sampler, uint32_t sample_rate_hz)
+{
+	/* The block interrupt has one sample period to reopen the gate */
+	if (!sample_rate_hz ||
+	    ((USEC_PER_SEC / sample_rate_hz) < CONFIG_SPIM_SAMPLER_ISR_LATENCY_US)) {
+		return -EINVAL;
+	}
+
+	uint32_t ticks = nrfx_timer_us_to_ticks(sampler->sample_timer,
+						USEC_PER_SEC / sample_rate_hz);
+
+	if (sampler->running) {
+		nrfx_timer_pause(sampler->sample_timer);
+	}
+
+	/* Restart the period so the new compare value is never behind the
+	 * counter, which would delay the next sample by a full timer wrap.
+	 */
+	nrfx_timer_clear(sampler->sample_timer);
+	nrfx_timer_extended_compare(sampler->sample_timer,
+				    NRF_TIMER_CC_CHANNEL0,
+				    ticks,
+				    NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK,
+				    false);
+	sampler->cfg.sample_rate_hz = sample_rate_hz;
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+	sampler->period_ticks = ticks * (SPIM_SAMPLER_TIMESTAMP_HZ /
+					 nrfx_timer_us_to_ticks(sampler->sample_timer,
+								USEC_PER_SEC));
+#endif
+
+	if (sampler->running) {
+		nrfx_timer_resume(sampler->sample_timer);
+	}
+
+	return 0;
+}
+
+uint32_t spim_sampler_dropped_get(const struct spim_sampler *sampler)
+{
+	return sampler->blocks_dropped;
+}
+
+void spim_sampler_metrics_get(const struct spim_sampler *sampler,
+			      struct spim_sampler_metrics *out)
+{
+	unsigned int key = irq_lock();
+
+	*out = sampler->metrics;
+	irq_unlock(key);
+}
+
+/* Refresh the published metrics, at most once per second */
+static void metrics_update(struct spim_sampler *sampler)
+{
+	struct spim_sampler_stats *stats = &sampler->stats;
+	int64_t now_ms = k_uptime_get();
+	int64_t elapsed_ms = now_ms - stats->last_ms;
+	struct spim_sampler_metrics m;
+
+	if (elapsed_ms < MSEC_PER_SEC) {
+		return;
+	}
+
+	m.wakeups_per_sec = ((sampler->wakeups - stats->last_wakeups) * MSEC_PER_SEC) /
+			    elapsed_ms;
+	m.samples_per_sec = ((sampler->block_seq - stats->last_seq) *
+			     sampler->cfg.block_samples * MSEC_PER_SEC) / elapsed_ms;
+	/* Every sample used to wake the CPU through the SPIM END interrupt */
+	m.saved_current_ua = ((m.samples_per_sec - m.wakeups_per_sec) *
+			      CONFIG_SPIM_SAMPLER_WAKEUP_CHARGE_NC) / 1000;
+
+	unsigned int key = irq_lock();
+
+	sampler->metrics = m;
+	irq_unlock(key);
+
+	stats->last_ms = now_ms;
+	stats->last_wakeups = sampler->wakeups;
+	stats->last_seq = sampler->block_seq;
+}
+
+static void spim_sampler_thread(void)
+{
+	struct block_msg msg;
+	struct spim_sampler_block block;
+
+	for (;;) {
+		k_msgq_get(&block_msgq, &msg, K_FOREVER);
+
+		struct spim_sampler *sampler = msg.sampler;
+		size_t block_size = sampler->cfg.sample_size * sampler->cfg.block_samples;
+
+		k_mutex_lock(&consumer_lock, K_FOREVER);
+		if (msg.generation != sampler->generation) {
+			k_mutex_unlock(&consumer_lock);
+			continue;
+		}
+
+		/* The ring has wrapped onto the block since it was queued */
+		if ((sampler->block_seq - msg.seq) >= sampler->block_count) {
+			unsigned int key = irq_lock();
+
+			sampler->blocks_dropped++;
+			irq_unlock(key);
+			k_mutex_unlock(&consumer_lock);
+			continue;
+		}
+
+		block.data = &sampler->cfg.ring[msg.index * block_size];
+		block.samples = sampler->cfg.block_samples;
+		block.sample_size = sampler->cfg.sample_size;
+		block.seq = msg.seq;
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+		block.timestamp = msg.timestamp;
+		block.end_timestamp = msg.end_timestamp;
+		block.period_ticks = sampler->period_ticks;
+#endif
+
+		metrics_update(sampler);
+
+		sampler->cfg.cb(sampler, &block, sampler->cfg.user_data);
+		k_mutex_unlock(&consumer_lock);
+	}
+}
+
+K_THREAD_DEFINE(spim_sampler_thread_id, CONFIG_SPIM_SAMPLER_THREAD_STACK_SIZE,
+		spim_sampler_thread, NULL, NULL, NULL,
+		CONFIG_SPIM_SAMPLER_THREAD_PRIORITY, 0, 0);
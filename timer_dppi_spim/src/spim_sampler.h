@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SPIM_SAMPLER_H_
+#define SPIM_SAMPLER_H_
+
+#include <zephyr.h>
+#include <nrfx_spim.h>
+#include <nrfx_timer.h>
+
+#include "gppi_graph.h"
+
+/*
+ * Periodic SPI sampling without CPU involvement per sample.
+ *
+ * A TIMER triggers SPIM START over DPPI at the sample rate. EasyDMA
+ * ArrayList places the received bytes of every transfer back to back in
+ * a ring of blocks, and a second TIMER in counter mode counts SPIM END
+ * so the CPU is only interrupted once per block. Completed blocks are
+ * passed to the callback from a shared consumer thread.
+ *
+ * The end of every block also closes a (D)PPI group around the START
+ * link, and the block interrupt reopens it once RXD.PTR is set for the
+ * next block. A late interrupt therefore never lets EasyDMA write past
+ * the ring; the samples due meanwhile are skipped, which shows as a gap
+ * between the timestamps of two blocks.
+ *
+ * Each sampler takes two TIMER instances from the ones enabled with
+ * CONFIG_NRFX_TIMERn, three (D)PPI channels and one (D)PPI group, so the
+ * number of concurrent samplers is limited by the TIMER instances left
+ * free on the SoC.
+ *
+ * With CONFIG_SPIM_SAMPLER_TIMESTAMP one more TIMER runs free at 16 MHz,
+ * shared by all samplers. SPIM START and END are also routed to its
+ * CAPTURE tasks, so each block carries the hardware time of its last
+ * transfer. Every sampler uses two of its CC channels.
+ */
+
+struct spim_sampler;
+
+/* Ticks per second of the block timestamps */
+#define SPIM_SAMPLER_TIMESTAMP_HZ 16000000
+
+/* A block of back to back samples, sample_size bytes each */
+struct spim_sampler_block {
+	const uint8_t *data;
+	size_t samples;
+	size_t sample_size;
+	uint32_t seq;
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+	/* SPIM START of the last sample, captured in hardware */
+	uint32_t timestamp;
+	/* SPIM END of the last sample, captured in hardware */
+	uint32_t end_timestamp;
+	/* Nominal interval between two samples in timestamp ticks */
+	uint32_t period_ticks;
+#endif
+};
+
+/* Called from the consumer thread for every completed block. The block
+ * data stays valid until the ring wraps around to it again.
+ */
+typedef void (*spim_sampler_block_cb_t)(struct spim_sampler *sampler,
+					const struct spim_sampler_block *block,
+					void *user_data);
+
+/* Wakeup statistics, refreshed once per second by the consumer thread */
+struct spim_sampler_metrics {
+	/* Sampler interrupts per second */
+	uint32_t wakeups_per_sec;
+	/* SPI transfers per second */
+	uint32_t samples_per_sec;
+	/* Estimated current saved compared to one interrupt per transfer */
+	uint32_t saved_current_ua;
+};
+
+struct spim_sampler_config {
+	/* SPIM instance, its CONFIG_NRFX_SPIMn must be enabled */
+	nrfx_spim_t spim;
+	/* Pins, frequency and mode of the SPIM */
+	nrfx_spim_config_t spim_config;
+	/* Bytes sent with every transfer, typically a register read command.
+	 * EasyDMA cannot read flash, so the buffer must be in RAM.
+	 */
+	const uint8_t *tx_buf;
+	size_t tx_len;
+	/* Bytes received with every transfer */
+	size_t sample_size;
+	/* Transfers per second */
+	uint32_t sample_rate_hz;
+	/* Transfers per block, which is also transfers per CPU wakeup */
+	size_t block_samples;
+	/* Ring storage, a whole number of blocks */
+	uint8_t *ring;
+	size_t ring_size;
+	spim_sampler_block_cb_t cb;
+	void *user_data;
+};
+
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+/* START time of sample idx of a block. Samples are started by the timer,
+ * so they are exactly period_ticks apart.
+ */
+static inline uint32_t spim_sampler_sample_time(const struct spim_sampler_block *block,
+						size_t idx)
+{
+	return block->timestamp - (block->samples - 1 - idx) * block->period_ticks;
+}
+#endif
+
+struct spim_sampler_stats {
+	int64_t last_ms;
+	uint32_t last_wakeups;
+	uint32_t last_seq;
+};
+
+/* Sampler instance, all fields are private */
+struct spim_sampler {
+	struct spim_sampler_config cfg;
+	nrfx_spim_xfer_desc_t transfer;
+	const nrfx_timer_t *sample_timer;
+	const nrfx_timer_t *count_timer;
+	/* Timer to SPIM START, SPIM END to the block counter and the block
+	 * end to the START gate
+	 */
+	struct gppi_graph graph;
+#ifdef CONFIG_SPIM_SAMPLER_TIMESTAMP
+	uint8_t ts_cc_start;
+	uint8_t ts_cc_end;
+	uint32_t period_ticks;
+#endif
+	size_t block_count;
+	uint32_t block_index;
+	uint32_t block_seq;
+	uint32_t blocks_dropped;
+	uint32_t wakeups;
+	/* Bumped by deinit, queued blocks of an older one are discarded */
+	uint32_t generation;
+	struct spim_sampler_metrics metrics;
+	struct spim_sampler_stats stats;
+	bool running;
+};
+
+/* Define ring storage for block_count blocks */
+#define SPIM_SAMPLER_RING_DEFINE(_name, _sample_size, _block_samples, _block_count) \
+	static uint8_t _name[(_sample_size) * (_block_samples) * (_block_count)] __aligned(4)
+
+/* Claim the peripherals and set up the pipeline, sampling is not started */
+int spim_sampler_init(struct spim_sampler *sampler,
+		      const struct spim_sampler_config *config);
+
+/* Start periodic sampling into the ring */
+int spim_sampler_start(struct spim_sampler *sampler);
+
+/* Stop sampling and release the peripherals taken by spim_sampler_init().
+ * No callback runs for the sampler once this returns. Blocks still queued
+ * are discarded, but the sampler itself is looked at once more for each,
+ * so it has to stay allocated.
+ */
+int spim_sampler_deinit(struct spim_sampler *sampler);
+
+/* Change the sample rate. The sample timer is restarted, so the interval
+ * around the change is shorter than the new period at most once. Rates
+ * with a period below CONFIG_SPIM_SAMPLER_ISR_LATENCY_US are rejected.
+ */
+int spim_sampler_rate_set(struct spim_sampler *sampler, uint32_t sample_rate_hz);
+
+/* Blocks lost because the consumer did not keep up, either because the
+ * queue was full or because the ring had wrapped onto them
+ */
+uint32_t spim_sampler_dropped_get(const struct spim_sampler *sampler);
+
+/* Copy the latest wakeup statistics */
+void spim_sampler_metrics_get(const struct spim_sampler *sampler,
+			      struct spim_sampler_metrics *metrics);
+
+#endif /* SPIM_SAMPLER_H_ */
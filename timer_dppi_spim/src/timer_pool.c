@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+
+#include "timer_pool.h"
+
+#define IRQ_PRIO CONFIG_TIMER_POOL_IRQ_PRIORITY
+
+struct timer_slot {
+	const nrfx_timer_t timer;
+	bool used;
+};
+
+static struct timer_slot timer_pool[] = {
+#ifdef CONFIG_NRFX_TIMER0
+	{ .timer = NRFX_TIMER_INSTANCE(0) },
+#endif
+#ifdef CONFIG_NRFX_TIMER1
+	{ .timer = NRFX_TIMER_INSTANCE(1) },
+#endif
+#ifdef CONFIG_NRFX_TIMER2
+	{ .timer = NRFX_TIMER_INSTANCE(2) },
+#endif
+#ifdef CONFIG_NRFX_TIMER3
+	{ .timer = NRFX_TIMER_INSTANCE(3) },
+#endif
+#ifdef CONFIG_NRFX_TIMER4
+	{ .timer = NRFX_TIMER_INSTANCE(4) },
+#endif
+};
+
+static void irq_connect_all(void)
+{
+	static bool connected;
+
+	if (connected) {
+		return;
+	}
+	connected = true;
+
+#ifdef CONFIG_NRFX_TIMER0
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TIMER0), IRQ_PRIO,
+		    nrfx_timer_0_irq_handler, NULL, 0);
+#endif
+#ifdef CONFIG_NRFX_TIMER1
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TIMER1), IRQ_PRIO,
+		    nrfx_timer_1_irq_handler, NULL, 0);
+#endif
+#ifdef CONFIG_NRFX_TIMER2
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TIMER2), IRQ_PRIO,
+		    nrfx_timer_2_irq_handler, NULL, 0);
+#endif
+#ifdef CONFIG_NRFX_TIMER3
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TIMER3), IRQ_PRIO,
+		    nrfx_timer_3_irq_handler, NULL, 0);
+#endif
+#ifdef CONFIG_NRFX_TIMER4
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TIMER4), IRQ_PRIO,
+		    nrfx_timer_4_irq_handler, NULL, 0);
+#endif
+}
+
+const nrfx_timer_t *timer_pool_claim(void)
+{
+	const nrfx_timer_t *timer = NULL;
+	unsigned int key = irq_lock();
+
+	irq_connect_all();
+
+	for (size_t i = 0; i < ARRAY_SIZE(timer_pool); i++) {
+		if (!timer_pool[i].used) {
+			timer_pool[i].used = true;
+			timer = &timer_pool[i].timer;
+			break;
+		}
+	}
+
+	irq_unlock(key);
+	return timer;
+}
+
+void timer_pool_release(const nrfx_timer_t *timer)
+{
+	struct timer_slot *slot = CONTAINER_OF(timer, struct timer_slot, timer);
+
+	slot->used = false;
+}
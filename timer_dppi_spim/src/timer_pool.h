@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TIMER_POOL_H_
+#define TIMER_POOL_H_
+
+#include <zephyr.h>
+#include <nrfx_timer.h>
+
+/*
+ * TIMER instances shared by the SPIM sampler and the TWIM batch queue.
+ *
+ * Every instance enabled with CONFIG_NRFX_TIMERn is in the pool and has
+ * its interrupt connected on the first claim, as IRQ_CONNECT needs build
+ * time constants.
+ */
+
+/* Claim a free instance, NULL when all are taken */
+const nrfx_timer_t *timer_pool_claim(void);
+
+void timer_pool_release(const nrfx_timer_t *timer);
+
+#endif /* TIMER_POOL_H_ */
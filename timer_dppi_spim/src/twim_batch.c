@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+
+#include <nrfx_timer.h>
+#include <nrfx_twim.h>
+
+#include <string.h>
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(twim_batch, LOG_LEVEL_INF);
+
+#include "twim_batch.h"
+#include "timer_pool.h"
+
+#define IRQ_PRIO CONFIG_TWIM_BATCH_IRQ_PRIORITY
+
+/* START, address, register, repeated START, address and STOP */
+#define XFER_OVERHEAD_BITS (1 + 9 + 9 + 1 + 9 + 1)
+
+struct done_msg {
+	struct twim_batch *batch;
+	int err;
+};
+
+K_MSGQ_DEFINE(done_msgq, sizeof(struct done_msg), CONFIG_TWIM_BATCH_QUEUE_SIZE, 4);
+
+static void irq_connect_all(void)
+{
+	static bool connected;
+
+	if (connected) {
+		return;
+	}
+	connected = true;
+
+	/* TWIMn shares its interrupt with SPIMn, only one can be enabled */
+#ifdef CONFIG_NRFX_TWIM0
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TWIM0), IRQ_PRIO, nrfx_isr,
+		    nrfx_twim_0_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_TWIM1
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TWIM1), IRQ_PRIO, nrfx_isr,
+		    nrfx_twim_1_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_TWIM2
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TWIM2), IRQ_PRIO, nrfx_isr,
+		    nrfx_twim_2_irq_handler, 0);
+#endif
+#ifdef CONFIG_NRFX_TWIM3
+	IRQ_CONNECT(NRFX_IRQ_NUMBER_GET(NRF_TWIM3), IRQ_PRIO, nrfx_isr,
+		    nrfx_twim_3_irq_handler, 0);
+#endif
+}
+
+static uint32_t frequency_hz(nrf_twim_frequency_t frequency)
+{
+	switch (frequency) {
+	case NRF_TWIM_FREQ_100K:
+		return 100000;
+	case NRF_TWIM_FREQ_250K:
+		return 250000;
+	default:
+		return 400000;
+	}
+}
+
+static void timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+	/* Nothing here due to DPPI */
+}
+
+static uint32_t start_eep(const struct twim_batch_queue *queue)
+{
+	return nrf_timer_event_address_get(queue->timer->p_reg, NRF_TIMER_EVENT_COMPARE0);
+}
+
+static uint32_t start_tep(const struct twim_batch_queue *queue)
+{
+	return nrfx_twim_start_task_get(&queue->cfg.twim, NRFX_TWIM_XFER_TXRX);
+}
+
+static int xfer_start(struct twim_batch_queue *queue, struct twim_batch *batch,
+		      uint32_t flags)
+{
+	const struct twim_batch_xfer *xfer = &batch->xfers[batch->xfer_index];
+	nrfx_twim_xfer_desc_t desc = NRFX_TWIM_XFER_DESC_TXRX(xfer->addr,
+							      &batch->tx[batch->xfer_index], 1,
+							      &batch->buf[xfer->offset],
+							      xfer->len);
+	nrfx_err_t err = nrfx_twim_xfer(&queue->cfg.twim, &desc, flags);
+
+	if (err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_twim_xfer error: %08x", err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Set up the periodic batch so the next timer tick starts it */
+static void periodic_arm(struct twim_batch_queue *queue)
+{
+	struct twim_batch *batch = queue->periodic;
+
+	batch->xfer_index = 0;
+	queue->active = batch;
+
+	nrf_twim_event_clear(queue->cfg.twim.p_reg, NRF_TWIM_EVENT_TXSTARTED);
+	nrf_timer_event_clear(queue->timer->p_reg, NRF_TIMER_EVENT_COMPARE0);
+	if (xfer_start(queue, batch, NRFX_TWIM_FLAG_HOLD_XFER)) {
+		queue->active = NULL;
+		return;
+	}
+
+	gppi_graph_links_enable(&queue->graph, BIT(0));
+}
+
+/* Start the next batch from the CPU, caller holds the irq lock */
+static void next_start(struct twim_batch_queue *queue)
+{
+	sys_snode_t *node;
+
+	if (queue->periodic) {
+		periodic_arm(queue);
+		return;
+	}
+
+	node = sys_slist_get(&queue->pending);
+	if (!node) {
+		return;
+	}
+
+	queue->active = CONTAINER_OF(node, struct twim_batch, node);
+	queue->active->xfer_index = 0;
+	if (xfer_start(queue, queue->active, 0)) {
+		/* Report the failure from the handler path */
+		struct done_msg msg = { .batch = queue->active, .err = -EIO };
+
+		queue->active->queue = NULL;
+		queue->active = NULL;
+		(void)k_msgq_put(&done_msgq, &msg, K_NO_WAIT);
+	}
+}
+
+static void batch_complete(struct twim_batch_queue *queue, struct twim_batch *batch, int err)
+{
+	struct done_msg msg = {
+		.batch = batch,
+		.err = err,
+	};
+
+	queue->stats.batches++;
+	queue->stats.merged += batch->read_count - batch->xfer_count;
+	if (err) {
+		queue->stats.errors++;
+	}
+
+	if (batch == queue->periodic) {
+		/* A tick while the trigger was gated is a skipped run */
+		if (nrf_timer_event_check(queue->timer->p_reg, NRF_TIMER_EVENT_COMPARE0)) {
+			queue->stats.overruns++;
+		}
+	} else {
+		batch->queue = NULL;
+	}
+
+	batch->seq++;
+	queue->active = NULL;
+
+	if (k_msgq_put(&done_msgq, &msg, K_NO_WAIT)) {
+		queue->stats.dropped++;
+	}
+
+	next_start(queue);
+}
+
+static void twim_handler(nrfx_twim_evt_t const *p_event, void *p_context)
+{
+	struct twim_batch_queue *queue = p_context;
+	struct twim_batch *batch = queue->active;
+
+	queue->stats.interrupts++;
+
+	if (!batch) {
+		return;
+	}
+
+	queue->stats.transfers++;
+
+	if ((batch == queue->periodic) && (batch->xfer_index == 0)) {
+		/* The first transfer was started by the timer, keep further
+		 * ticks away from the TWIM until the chain is done.
+		 */
+		gppi_graph_links_disable(&queue->graph, BIT(0));
+		nrf_timer_event_clear(queue->timer->p_reg, NRF_TIMER_EVENT_COMPARE0);
+	}
+
+	if (p_event->type != NRFX_TWIM_EVT_DONE) {
+		batch_complete(queue, batch, -EIO);
+		return;
+	}
+
+	if (++batch->xfer_index == batch->xfer_count) {
+		batch_complete(queue, batch, 0);
+		return;
+	}
+
+	if (xfer_start(queue, batch, 0)) {
+		batch_complete(queue, batch, -EIO);
+	}
+}
+
+int twim_batch_queue_init(struct twim_batch_queue *queue,
+			  const struct twim_batch_queue_config *config)
+{
+	nrfx_err_t err_code;
+
+	memset(queue, 0, sizeof(*queue));
+	queue->cfg = *config;
+	queue->frequency_hz = frequency_hz(config->twim_config.frequency);
+	sys_slist_init(&queue->pending);
+
+	irq_connect_all();
+
+	err_code = nrfx_twim_init(&queue->cfg.twim, &queue->cfg.twim_config,
+				  twim_handler, queue);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_twim_init error: %08x", err_code);
+		return -EIO;
+	}
+
+	nrfx_twim_enable(&queue->cfg.twim);
+
+	return 0;
+}
+
+int twim_batch_prepare(struct twim_batch *batch)
+{
+	struct twim_batch_xfer *xfer = NULL;
+	size_t offset = 0;
+
+	if (batch->queue) {
+		return -EBUSY;
+	}
+
+	batch->xfer_count = 0;
+
+	for (size_t i = 0; i < batch->read_count; i++) {
+		struct twim_batch_read *read = &batch->reads[i];
+
+		if (!read->len) {
+			return -EINVAL;
+		}
+
+		if ((offset + read->len) > sizeof(batch->buf)) {
+			return -ENOMEM;
+		}
+
+		if (IS_ENABLED(CONFIG_TWIM_BATCH_MERGE) && xfer &&
+		    (xfer->addr == read->addr) &&
+		    ((xfer->reg + xfer->len) == read->reg) &&
+		    ((xfer->len + read->len) <= UINT8_MAX)) {
+			xfer->len += read->len;
+		} else {
+			if (batch->xfer_count == ARRAY_SIZE(batch->xfers)) {
+				return -ENOMEM;
+			}
+
+			xfer = &batch->xfers[batch->xfer_count];
+			xfer->addr = read->addr;
+			xfer->reg = read->reg;
+			xfer->len = read->len;
+			xfer->offset = offset;
+			batch->tx[batch->xfer_count] = read->reg;
+			batch->xfer_count++;
+		}
+
+		read->data = &batch->buf[offset];
+		offset += read->len;
+	}
+
+	return batch->xfer_count ? 0 : -EINVAL;
+}
+
+uint32_t twim_batch_duration_us(const struct twim_batch_queue *queue,
+				const struct twim_batch *batch)
+{
+	uint32_t bits = 0;
+
+	for (size_t i = 0; i < batch->xfer_count; i++) {
+		bits += XFER_OVERHEAD_BITS + 9 * batch->xfers[i].len;
+	}
+
+	return DIV_ROUND_UP((uint64_t)bits * USEC_PER_SEC, queue->frequency_hz);
+}
+
+int twim_batch_submit(struct twim_batch_queue *queue, struct twim_batch *batch)
+{
+	int err = 0;
+
+	if (!batch->xfer_count || !batch->cb) {
+		return -EINVAL;
+	}
+
+	unsigned int key = irq_lock();
+
+	if (queue->periodic) {
+		err = -EBUSY;
+	} else if (batch->queue) {
+		err = -EALREADY;
+	} else {
+		batch->queue = queue;
+		sys_slist_append(&queue->pending, &batch->node);
+		if (!queue->active) {
+			next_start(queue);
+		}
+	}
+
+	irq_unlock(key);
+
+	return err;
+}
+
+static int dppi_link(struct twim_batch_queue *queue)
+{
+	const struct gppi_graph_link link = {
+		.eep = start_eep(queue),
+		.tep = start_tep(queue),
+		.group = GPPI_GRAPH_NO_GROUP,
+		/* Enabled when the batch is armed */
+		.start_disabled = true,
+	};
+	const struct gppi_graph_desc desc = {
+		.links = &link,
+		.link_count = 1,
+	};
+
+	return gppi_graph_setup(&queue->graph, &desc);
+}
+
+static int timer_init(struct twim_batch_queue *queue, uint32_t period_us)
+{
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+	nrfx_err_t err_code;
+
+	queue->timer = timer_pool_claim();
+	if (!queue->timer) {
+		LOG_ERR("No free TIMER instance");
+		return -EBUSY;
+	}
+
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	err_code = nrfx_timer_init(queue->timer, &timer_config, timer_handler);
+	if (err_code != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_timer_init error: %08x", err_code);
+		timer_pool_release(queue->timer);
+		return -EIO;
+	}
+
+	nrfx_timer_extended_compare(queue->timer, NRF_TIMER_CC_CHANNEL0,
+				    nrfx_timer_us_to_ticks(queue->timer, period_us),
+				    NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+
+	return 0;
+}
+
+static void timer_deinit(struct twim_batch_queue *queue)
+{
+	nrfx_timer_uninit(queue->timer);
+	timer_pool_release(queue->timer);
+	queue->timer = NULL;
+}
+
+int twim_batch_periodic_start(struct twim_batch_queue *queue, struct twim_batch *batch,
+			      uint32_t period_us)
+{
+	int err;
+
+	if (!batch->xfer_count || !batch->cb) {
+		return -EINVAL;
+	}
+
+	if (period_us <= twim_batch_duration_us(queue, batch)) {
+		LOG_ERR("Batch takes %u us, longer than the period",
+			twim_batch_duration_us(queue, batch));
+		return -EINVAL;
+	}
+
+	unsigned int key = irq_lock();
+	bool busy = queue->periodic || queue->active || !sys_slist_is_empty(&queue->pending) ||
+		    batch->queue;
+
+	if (!busy) {
+		/* Keeps submissions out while the pipeline is set up */
+		batch->queue = queue;
+		queue->periodic = batch;
+	}
+	irq_unlock(key);
+
+	if (busy) {
+		return -EBUSY;
+	}
+
+	err = timer_init(queue, period_us);
+	if (err) {
+		goto clear;
+	}
+
+	err = dppi_link(queue);
+	if (err) {
+		goto uninit_timer;
+	}
+
+	key = irq_lock();
+	periodic_arm(queue);
+	irq_unlock(key);
+
+	if (!queue->active) {
+		err = -EIO;
+		goto unlink;
+	}
+
+	nrfx_timer_enable(queue->timer);
+
+	LOG_INF("Periodic batch on TWIM%u: %u transfers every %u us, %u us on the bus",
+		queue->cfg.twim.drv_inst_idx, batch->xfer_count, period_us,
+		twim_batch_duration_us(queue, batch));
+
+	return 0;
+
+unlink:
+	gppi_graph_teardown(&queue->graph);
+uninit_timer:
+	timer_deinit(queue);
+clear:
+	queue->periodic = NULL;
+	batch->queue = NULL;
+	return err;
+}
+
+int twim_batch_periodic_stop(struct twim_batch_queue *queue)
+{
+	struct twim_batch *batch = queue->periodic;
+
+	if (!batch) {
+		return -EALREADY;
+	}
+
+	nrfx_timer_disable(queue->timer);
+
+	unsigned int key = irq_lock();
+
+	queue->periodic = NULL;
+	batch->queue = NULL;
+	gppi_graph_teardown(&queue->graph);
+
+	/* An armed transfer that never got its tick is still held by the
+	 * driver, run it so the chain completes and releases the TWIM.
+	 */
+	if ((queue->active == batch) && (batch->xfer_index == 0) &&
+	    !nrf_twim_event_check(queue->cfg.twim.p_reg, NRF_TWIM_EVENT_TXSTARTED)) {
+		nrf_twim_task_trigger(queue->cfg.twim.p_reg, NRF_TWIM_TASK_STARTTX);
+	}
+
+	irq_unlock(key);
+
+	timer_deinit(queue);
+
+	return 0;
+}
+
+void twim_batch_stats_get(const struct twim_batch_queue *queue,
+			  struct twim_batch_stats *stats)
+{
+	unsigned int key = irq_lock();
+
+	*stats = queue->stats;
+	irq_unlock(key);
+}
+
+static void twim_batch_thread(void)
+{
+	struct done_msg msg;
+
+	for (;;) {
+		k_msgq_get(&done_msgq, &msg, K_FOREVER);
+
+		msg.batch->cb(msg.batch, msg.err, msg.batch->user_data);
+	}
+}
+
+K_THREAD_DEFINE(twim_batch_thread_id, CONFIG_TWIM_BATCH_THREAD_STACK_SIZE,
+		twim_batch_thread, NULL, NULL, NULL,
+		CONFIG_TWIM_BATCH_THREAD_PRIORITY, 0, 0);
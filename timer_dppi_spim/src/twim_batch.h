@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2021 Joao Dullius
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TWIM_BATCH_H_
+#define TWIM_BATCH_H_
+
+#include <zephyr.h>
+#include <nrfx_twim.h>
+#include <nrfx_timer.h>
+
+#include "gppi_graph.h"
+
+/*
+ * Batched register reads on a TWIM.
+ *
+ * A batch is a list of register reads, possibly on several devices.
+ * Adjacent reads of consecutive registers on the same device are merged
+ * into one transfer, so a batch becomes a short chain of write-register,
+ * read-data transfers into a single EasyDMA buffer. The TWIM interrupt
+ * starts the next transfer of the chain right away and the caller only
+ * hears about the batch once, from the consumer thread, when it is
+ * complete.
+ *
+ * Batches are either submitted one at a time or run periodically. In
+ * periodic mode a TIMER from the pool starts the first transfer over
+ * DPPI, so the polling rate does not depend on thread scheduling. The
+ * TWIM can only address one device per transfer, so the chain is still
+ * advanced by one short interrupt per merged transfer. No periodic tick
+ * may hit a running batch, so the period has to be longer than the time
+ * the whole batch takes on the bus. Ticks that arrive while the chain
+ * is still running are skipped and counted.
+ */
+
+struct twim_batch_queue;
+struct twim_batch;
+
+/* One register read. data points into the batch buffer once the batch
+ * is prepared and holds the result when the batch completes.
+ */
+struct twim_batch_read {
+	uint8_t addr;
+	uint8_t reg;
+	uint8_t len;
+	const uint8_t *data;
+};
+
+/* Called from the consumer thread once per completed batch. err is 0 or
+ * -EIO when a transfer was not acknowledged, which ends the batch. The
+ * read data stays valid until the batch runs again, for a periodic batch
+ * that is the next period.
+ */
+typedef void (*twim_batch_cb_t)(struct twim_batch *batch, int err, void *user_data);
+
+/* Private, one transfer of the chain */
+struct twim_batch_xfer {
+	uint8_t addr;
+	uint8_t reg;
+	uint8_t len;
+	uint16_t offset;
+};
+
+struct twim_batch {
+	struct twim_batch_read *reads;
+	size_t read_count;
+	twim_batch_cb_t cb;
+	void *user_data;
+	/* Completed runs */
+	uint32_t seq;
+
+	/* Private */
+	sys_snode_t node;
+	struct twim_batch_queue *queue;
+	struct twim_batch_xfer xfers[CONFIG_TWIM_BATCH_MAX_XFERS];
+	size_t xfer_count;
+	size_t xfer_index;
+	/* Register address bytes sent by the chain, EasyDMA reads them */
+	uint8_t tx[CONFIG_TWIM_BATCH_MAX_XFERS];
+	uint8_t buf[CONFIG_TWIM_BATCH_BUF_SIZE];
+};
+
+struct twim_batch_queue_config {
+	/* TWIM instance, its CONFIG_NRFX_TWIMn must be enabled */
+	nrfx_twim_t twim;
+	/* Pins and frequency of the TWIM */
+	nrfx_twim_config_t twim_config;
+};
+
+struct twim_batch_stats {
+	uint32_t batches;
+	uint32_t transfers;
+	/* Interrupts taken, one per transfer */
+	uint32_t interrupts;
+	/* Register reads saved by merging */
+	uint32_t merged;
+	uint32_t errors;
+	/* Periodic ticks that hit a running batch and were skipped */
+	uint32_t overruns;
+	/* Completions lost because the consumer did not keep up */
+	uint32_t dropped;
+};
+
+/* Queue instance, all fields are private */
+struct twim_batch_queue {
+	struct twim_batch_queue_config cfg;
+	uint32_t frequency_hz;
+	sys_slist_t pending;
+	struct twim_batch *active;
+	struct twim_batch *periodic;
+	const nrfx_timer_t *timer;
+	/* Timer compare to STARTTX, link 0 gates the periodic ticks */
+	struct gppi_graph graph;
+	struct twim_batch_stats stats;
+};
+
+int twim_batch_queue_init(struct twim_batch_queue *queue,
+			  const struct twim_batch_queue_config *config);
+
+/*
+ * Merge the reads of a batch into transfers and point every read at its
+ * place in the batch buffer. Has to be called again after the reads
+ * are changed.
+ */
+int twim_batch_prepare(struct twim_batch *batch);
+
+/* Time the batch takes on the bus of a queue, in us */
+uint32_t twim_batch_duration_us(const struct twim_batch_queue *queue,
+				const struct twim_batch *batch);
+
+/* Queue a prepared batch to run once. Not allowed while a periodic batch
+ * runs, as its timer could start a transfer in the middle of it.
+ */
+int twim_batch_submit(struct twim_batch_queue *queue, struct twim_batch *batch);
+
+/* Run a prepared batch every period_us, started by a TIMER over DPPI */
+int twim_batch_periodic_start(struct twim_batch_queue *queue, struct twim_batch *batch,
+			      uint32_t period_us);
+
+/* Stop the periodic batch, a batch on the bus is still completed */
+int twim_batch_periodic_stop(struct twim_batch_queue *queue);
+
+void twim_batch_stats_get(const struct twim_batch_queue *queue,
+			  struct twim_batch_stats *stats);
+
+#endif /* TWIM_BATCH_H_ */
@@ -0,0 +1,229 @@
+#include "capture.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(capture, LOG_LEVEL_INF);
+
+BUILD_ASSERT((CAPTURE_RING_SIZE & (CAPTURE_RING_SIZE - 1)) == 0,
+	     "CAPTURE_RING_SIZE must be a power of two");
+
+static void ring_put(struct capture *cap, uint32_t width, uint32_t period)
+{
+	atomic_val_t head = atomic_get(&cap->head);
+
+	if ((head - atomic_get(&cap->tail)) >= CAPTURE_RING_SIZE) {
+		atomic_inc(&cap->overflows);
+		return;
+	}
+
+	cap->ring[head & (CAPTURE_RING_SIZE - 1)] = (struct capture_record){
+		.width = width,
+		.period = period,
+	};
+	atomic_set(&cap->head, head + 1);
+}
+
+static uint32_t capture_tep(const struct capture *cap, nrf_timer_cc_channel_t channel)
+{
+	return nrfx_timer_task_address_get(&cap->timer, nrf_timer_capture_task_get(channel));
+}
+
+static void timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+	/* Nothing here due to (D)PPI */
+}
+
+static void edge_handler(nrfx_gpiote_pin_t pin, nrfx_gpiote_trigger_t trigger,
+			 void *p_context)
+{
+	struct capture *cap = p_context;
+	/* Time since the previous rising edge, the timer was cleared right after */
+	uint32_t period = nrfx_timer_capture_get(&cap->timer, NRF_TIMER_CC_CHANNEL0);
+	/* Falling edge of the same cycle, stays valid until the next one */
+	uint32_t width = (cap->mode == CAPTURE_MODE_PULSE) ?
+			 nrfx_timer_capture_get(&cap->timer, NRF_TIMER_CC_CHANNEL1) : 0;
+
+	/* The first edge only starts the timer from a known point */
+	if (cap->has_edge) {
+		ring_put(cap, width, period);
+	}
+
+	cap->has_edge = true;
+}
+
+static nrfx_err_t input_configure(nrfx_gpiote_pin_t pin, nrf_gpio_pin_pull_t pull,
+				  nrfx_gpiote_trigger_t trigger, uint8_t *gpiote_ch,
+				  const nrfx_gpiote_handler_config_t *handler_config)
+{
+	const nrfx_gpiote_input_config_t input_config = {
+		.pull = pull,
+	};
+	const nrfx_gpiote_trigger_config_t trigger_config = {
+		.trigger = trigger,
+		.p_in_channel = gpiote_ch,
+	};
+
+	return nrfx_gpiote_input_configure(pin, &input_config, &trigger_config, handler_config);
+}
+
+int capture_init(struct capture *cap, const struct capture_config *config)
+{
+	nrfx_err_t err;
+
+	memset(cap, 0, sizeof(*cap));
+	cap->timer = config->timer;
+	cap->pin = config->pin;
+	cap->pin_fall = config->pin_fall;
+	cap->mode = config->mode;
+
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+
+	timer_config.frequency = NRF_TIMER_FREQ_16MHz;
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	err = nrfx_timer_init(&cap->timer, &timer_config, timer_handler);
+	if (err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_timer_init error: %08x", err);
+		return -EIO;
+	}
+
+	if (!nrfx_gpiote_is_init()) {
+		/* The priority is ignored, see nrfx_glue.h */
+		err = nrfx_gpiote_init(0);
+		if (err != NRFX_SUCCESS) {
+			LOG_ERR("nrfx_gpiote_init error: 0x%08X", err);
+			goto uninit_timer;
+		}
+	}
+
+	bool pulse = (cap->mode == CAPTURE_MODE_PULSE);
+
+	if (pulse && (cap->pin_fall == cap->pin)) {
+		/* GPIOTE takes one channel per pin */
+		LOG_ERR("Pulse mode needs the input on a second pin");
+		goto uninit_timer;
+	}
+
+	err = nrfx_gpiote_channel_alloc(&cap->gpiote_ch);
+	if (err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_gpiote_channel_alloc error: 0x%08X", err);
+		goto uninit_timer;
+	}
+
+	const nrfx_gpiote_handler_config_t handler_config = {
+		.handler = edge_handler,
+		.p_context = cap,
+	};
+
+	err = input_configure(cap->pin, config->pull, NRFX_GPIOTE_TRIGGER_LOTOHI,
+			      &cap->gpiote_ch, &handler_config);
+	if (err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_gpiote_input_configure error: 0x%08X", err);
+		goto free_gpiote;
+	}
+
+	if (pulse) {
+		err = nrfx_gpiote_channel_alloc(&cap->gpiote_ch_fall);
+		if (err != NRFX_SUCCESS) {
+			LOG_ERR("nrfx_gpiote_channel_alloc error: 0x%08X", err);
+			goto uninit_pin;
+		}
+
+		/* Only (D)PPI uses the falling edge, no interrupt */
+		err = input_configure(cap->pin_fall, config->pull, NRFX_GPIOTE_TRIGGER_HITOLO,
+				      &cap->gpiote_ch_fall, NULL);
+		if (err != NRFX_SUCCESS) {
+			LOG_ERR("nrfx_gpiote_input_configure error: 0x%08X", err);
+			goto free_gpiote_fall;
+		}
+	}
+
+	/* Rising edge: capture the period, then restart from 0.
+	 * Falling edge: capture the high time.
+	 */
+	const struct gppi_graph_link links[] = {
+		{
+			.eep = nrfx_gpiote_in_event_addr_get(cap->pin),
+			.tep = capture_tep(cap, NRF_TIMER_CC_CHANNEL0),
+			.fork_tep = nrfx_timer_task_address_get(&cap->timer,
+								NRF_TIMER_TASK_CLEAR),
+			.group = GPPI_GRAPH_NO_GROUP,
+		},
+		{
+			.eep = pulse ? nrfx_gpiote_in_event_addr_get(cap->pin_fall) : 0,
+			.tep = capture_tep(cap, NRF_TIMER_CC_CHANNEL1),
+			.group = GPPI_GRAPH_NO_GROUP,
+		},
+	};
+	const struct gppi_graph_desc desc = {
+		.links = links,
+		.link_count = pulse ? 2 : 1,
+	};
+
+	if (gppi_graph_setup(&cap->graph, &desc)) {
+		goto uninit_pin_fall;
+	}
+
+	nrfx_timer_enable(&cap->timer);
+	if (pulse) {
+		nrfx_gpiote_trigger_enable(cap->pin_fall, false);
+	}
+	nrfx_gpiote_trigger_enable(cap->pin, true);
+
+	return 0;
+
+uninit_pin_fall:
+	if (pulse) {
+		nrfx_gpiote_pin_uninit(cap->pin_fall);
+	}
+free_gpiote_fall:
+	if (pulse) {
+		nrfx_gpiote_channel_free(cap->gpiote_ch_fall);
+	}
+uninit_pin:
+	nrfx_gpiote_pin_uninit(cap->pin);
+free_gpiote:
+	nrfx_gpiote_channel_free(cap->gpiote_ch);
+uninit_timer:
+	nrfx_timer_uninit(&cap->timer);
+	return -EIO;
+}
+
+int capture_read(struct capture *cap, struct capture_record *record)
+{
+	atomic_val_t tail = atomic_get(&cap->tail);
+
+	if (tail == atomic_get(&cap->head)) {
+		return -EAGAIN;
+	}
+
+	*record = cap->ring[tail & (CAPTURE_RING_SIZE - 1)];
+	atomic_set(&cap->tail, tail + 1);
+
+	return 0;
+}
+
+uint32_t capture_overflows_get(const struct capture *cap)
+{
+	return atomic_get(&cap->overflows);
+}
+
+void capture_deinit(struct capture *cap)
+{
+	nrfx_gpiote_trigger_disable(cap->pin);
+	if (cap->mode == CAPTURE_MODE_PULSE) {
+		nrfx_gpiote_trigger_disable(cap->pin_fall);
+	}
+	gppi_graph_teardown(&cap->graph);
+
+	nrfx_gpiote_pin_uninit(cap->pin);
+	nrfx_gpiote_channel_free(cap->gpiote_ch);
+	if (cap->mode == CAPTURE_MODE_PULSE) {
+		nrfx_gpiote_pin_uninit(cap->pin_fall);
+		nrfx_gpiote_channel_free(cap->gpiote_ch_fall);
+	}
+
+	nrfx_timer_disable(&cap->timer);
+	nrfx_timer_uninit(&cap->timer);
+}
@@ -0,0 +1,97 @@
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <zephyr/kernel.h>
+#include <nrfx_timer.h>
+#include <nrfx_gpiote.h>
+
+#include "gppi_graph.h"
+
+/*
+ * Hardware input capture.
+ *
+ * A rising edge GPIOTE IN event on the input pin triggers, over one
+ * (D)PPI channel with a fork, the CAPTURE0 and CLEAR tasks of a TIMER
+ * running at 16 MHz. CC0 then holds the exact period and the interrupt
+ * only files it into a ring of measurements.
+ *
+ * CAPTURE_MODE_PULSE also captures the falling edge into CC1, which is
+ * the high time. GPIOTE assigns one channel per pin, so the signal has
+ * to be wired to a second pin as well, pin_fall, whose falling edge
+ * channel triggers CAPTURE1 over another (D)PPI channel. Both edges are
+ * timed by hardware. The interrupt on the rising edge reads CC1 and CC0,
+ * so it only has to run before the next falling edge.
+ * CAPTURE_MODE_PERIOD only uses the rising edges and gives the period
+ * alone.
+ *
+ * The application connects the GPIOTE interrupt to the nrfx handler.
+ */
+
+/* Counter frequency, 62.5 ns resolution */
+#define CAPTURE_TIMER_HZ 16000000
+
+/* Measurements kept until read, a power of two */
+#define CAPTURE_RING_SIZE 32
+
+enum capture_mode {
+	CAPTURE_MODE_PERIOD,
+	CAPTURE_MODE_PULSE,
+};
+
+/* One signal cycle in timer ticks, ending with a rising edge */
+struct capture_record {
+	/* High time, 0 in CAPTURE_MODE_PERIOD */
+	uint32_t width;
+	uint32_t period;
+};
+
+struct capture_config {
+	nrfx_timer_t timer;
+	nrfx_gpiote_pin_t pin;
+	/* Same signal as pin, only used in CAPTURE_MODE_PULSE */
+	nrfx_gpiote_pin_t pin_fall;
+	nrf_gpio_pin_pull_t pull;
+	enum capture_mode mode;
+};
+
+/* Capture instance, all fields are private */
+struct capture {
+	nrfx_timer_t timer;
+	nrfx_gpiote_pin_t pin;
+	nrfx_gpiote_pin_t pin_fall;
+	enum capture_mode mode;
+	uint8_t gpiote_ch;
+	uint8_t gpiote_ch_fall;
+	struct gppi_graph graph;
+	bool has_edge;
+	struct capture_record ring[CAPTURE_RING_SIZE];
+	atomic_t head;
+	atomic_t tail;
+	atomic_t overflows;
+};
+
+/* Claim the TIMER, GPIOTE and (D)PPI channels and start measuring */
+int capture_init(struct capture *cap, const struct capture_config *config);
+
+/* Get the oldest measurement, -EAGAIN when there is none */
+int capture_read(struct capture *cap, struct capture_record *record);
+
+/* Measurements lost because the ring was full */
+uint32_t capture_overflows_get(const struct capture *cap);
+
+/* Stop measuring and release all resources */
+void capture_deinit(struct capture *cap);
+
+static inline uint32_t capture_ticks_to_us(uint32_t ticks)
+{
+	return ticks / (CAPTURE_TIMER_HZ / USEC_PER_SEC);
+}
+
+/* Frequency in mHz of a measured period */
+static inline uint32_t capture_freq_mhz(const struct capture_record *record)
+{
+	return record->period ?
+	       (uint32_t)(((uint64_t)CAPTURE_TIMER_HZ * 1000) / record->period) : 0;
+}
+
+#endif /* CAPTURE_H_ */
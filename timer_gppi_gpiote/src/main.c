@@ -5,7 +5,6 @@
 #include <zephyr/timing/timing.h>
 
 #include <nrfx_timer.h>
-#include <nrfx_gpiote.h>
 
 //GPPI + PPI/DPPI includes based on DPPI presence on platform
 #include <helpers/nrfx_gppi.h>
@@ -15,126 +14,159 @@
 	#include <nrfx_ppi.h>
 #endif
 
+#include "waveform.h"
+#include "capture.h"
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(main, LOG_LEVEL_DBG);
 
 /* The devicetree node identifier for the "led0" alias. */
 #define LED0_PIN	DT_GPIO_PIN(DT_ALIAS(led0), gpios)
 
-static const nrfx_timer_t m_sample_timer = NRFX_TIMER_INSTANCE(1);
+#if DT_NODE_HAS_STATUS(DT_ALIAS(led1), okay)
+#define LED1_PIN	DT_GPIO_PIN(DT_ALIAS(led1), gpios)
+#endif
 
-void timer_handler(nrf_timer_event_t event_type, void* p_context)
-{
-	//Nothing here due to DPPI
-}
+/* Measured input, a button unless "capture-in" is aliased */
+#if DT_NODE_HAS_STATUS(DT_ALIAS(capture_in), okay)
+#define CAPTURE_PIN	DT_GPIO_PIN(DT_ALIAS(capture_in), gpios)
+#else
+#define CAPTURE_PIN	DT_GPIO_PIN(DT_ALIAS(sw0), gpios)
+#endif
 
-static void timer_init(void)
-{
-    nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
-	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
-    nrfx_err_t err_code = nrfx_timer_init(&m_sample_timer, &timer_config, timer_handler);
-    if (err_code != NRFX_SUCCESS) {
-        LOG_ERR("nrfx_timer_init error: %08x", err_code);
-        return;
-    }
-    nrfx_timer_extended_compare(&m_sample_timer,
-                                NRF_TIMER_CC_CHANNEL0,
-                                nrfx_timer_ms_to_ticks(&m_sample_timer, 500),
-                                NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK,
-                                true);
-    
-    LOG_INF("Timer 1 initialized.");
-    nrfx_timer_enable(&m_sample_timer);
-
-	
-    IRQ_CONNECT(TIMER1_IRQn, 0,
-         nrfx_timer_1_irq_handler, NULL, 0);
-}
+/* High time is only measured with the input also wired to "capture-fall" */
+#if DT_NODE_HAS_STATUS(DT_ALIAS(capture_fall), okay)
+#define CAPTURE_FALL_PIN	DT_GPIO_PIN(DT_ALIAS(capture_fall), gpios)
+#endif
 
-static void gpiote_init(void)
+#define WAVEFORM_TIMER_IDX	1
+#define CAPTURE_TIMER_IDX	2
+
+static struct waveform m_waveform;
+static struct capture m_capture;
+
+/* Two timings the outputs alternate between, switched at a period boundary */
+static const struct waveform_timing m_timings[] = {
+	{
+		.period_ns = 1000 * NSEC_PER_MSEC,
+		.out = {
+			{ .pulse_ns = 250 * NSEC_PER_MSEC, .phase_ns = 0 },
+			{ .pulse_ns = 250 * NSEC_PER_MSEC, .phase_ns = 500 * NSEC_PER_MSEC },
+		},
+	},
+	{
+		.period_ns = 200 * NSEC_PER_MSEC,
+		.out = {
+			{ .pulse_ns = 20 * NSEC_PER_MSEC, .phase_ns = 0 },
+			{ .pulse_ns = 150 * NSEC_PER_MSEC, .phase_ns = 100 * NSEC_PER_MSEC },
+		},
+	},
+};
+
+static int waveform_setup(void)
 {
-	nrfx_err_t err;
-	uint8_t out_channel;
+	int err;
+	struct waveform_config config = {
+		.timer = NRFX_TIMER_INSTANCE(WAVEFORM_TIMER_IDX),
+		.pins = {
+			LED0_PIN,
+#if defined(LED1_PIN)
+			LED1_PIN,
+#endif
+		},
+		.timing = m_timings[0],
+	};
 
-	/* Initialize GPIOTE (the interrupt priority passed as the parameter
-	 * here is ignored, see nrfx_glue.h).
-	 */
-	err = nrfx_gpiote_init(0);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("nrfx_gpiote_init error: 0x%08X", err);
-		return;
-	}
+#if defined(LED1_PIN)
+	config.output_count = 2;
+#else
+	config.output_count = 1;
+#endif
+	config.output_count = MIN(config.output_count,
+		WAVEFORM_OUTPUTS_FOR_CC(NRF_TIMER_CC_CHANNEL_COUNT(WAVEFORM_TIMER_IDX)));
 
-	err = nrfx_gpiote_channel_alloc(&out_channel);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("Failed to allocate out_channel, error: 0x%08X", err);
-		return;
-	}
-	
-	/* Initialize output pin. SET task will turn the LED on,
-	 * CLR will turn it off and OUT will toggle it.
-	 */
-	static const nrfx_gpiote_output_config_t output_config = {
-		.drive = NRF_GPIO_PIN_S0S1,
-		.input_connect = NRF_GPIO_PIN_INPUT_DISCONNECT,
-		.pull = NRF_GPIO_PIN_NOPULL,
-	};
-	const nrfx_gpiote_task_config_t task_config = {
-		.task_ch = out_channel,
-		.polarity = NRF_GPIOTE_POLARITY_TOGGLE,
-		.init_val = 1,
-	};
-	err = nrfx_gpiote_output_configure(LED0_PIN,
-					   &output_config,
-					   &task_config);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("nrfx_gpiote_output_configure error: 0x%08X", err);
-		return;
-	}
+	IRQ_CONNECT(TIMER1_IRQn, 0,
+		nrfx_timer_1_irq_handler, NULL, 0);
 
-	nrfx_gpiote_out_task_enable(LED0_PIN);
+	err = waveform_init(&m_waveform, &config);
+	if (err) {
+		LOG_ERR("waveform_init error: %d", err);
+		return err;
+	}
 
-	LOG_INF("nrfx_gpiote initialized");
+	LOG_INF("Waveform on %u output(s) initialized.", config.output_count);
 
+	return waveform_start(&m_waveform);
 }
 
-
-static void gppi_init(void)
+static int capture_setup(void)
 {
-	nrfx_err_t err;
-	uint8_t ppi_channel;
+	int err;
+	const struct capture_config config = {
+		.timer = NRFX_TIMER_INSTANCE(CAPTURE_TIMER_IDX),
+		.pin = CAPTURE_PIN,
+		.pull = NRF_GPIO_PIN_PULLUP,
+#if defined(CAPTURE_FALL_PIN)
+		.pin_fall = CAPTURE_FALL_PIN,
+		.mode = CAPTURE_MODE_PULSE,
+#else
+		.mode = CAPTURE_MODE_PERIOD,
+#endif
+	};
 
-	/* Allocate a (D)PPI channel. */
-	err = nrfx_gppi_channel_alloc(&ppi_channel);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("nrfx_gppi_channel_alloc error: 0x%08X", err);
-		return;
+	IRQ_CONNECT(DT_IRQN(DT_NODELABEL(gpiote)), DT_IRQ(DT_NODELABEL(gpiote), priority),
+		nrfx_isr, nrfx_gpiote_irq_handler, 0);
+
+	err = capture_init(&m_capture, &config);
+	if (err) {
+		LOG_ERR("capture_init error: %d", err);
+		return err;
 	}
 
-	/* Configure a (D)PPI channel to toggle the LED0 pin on TIMER0 COMPARE[0] match. */
-	nrfx_gppi_channel_endpoints_setup(ppi_channel,
-		nrf_timer_event_address_get(m_sample_timer.p_reg, NRF_TIMER_EVENT_COMPARE0),
-		nrfx_gpiote_out_task_addr_get(LED0_PIN));
+	LOG_INF("Capture on pin %u initialized.", CAPTURE_PIN);
 
-	/* Enable the channel. */
-	nrfx_gppi_channels_enable(BIT(ppi_channel));
+	return 0;
 }
 
+static void capture_log(void)
+{
+	struct capture_record record;
+
+	while (capture_read(&m_capture, &record) == 0) {
+		uint32_t freq = capture_freq_mhz(&record);
+
+		LOG_INF("Width %u us, period %u us, %u.%03u Hz",
+			capture_ticks_to_us(record.width), capture_ticks_to_us(record.period),
+			freq / 1000, freq % 1000);
+	}
+
+	if (capture_overflows_get(&m_capture)) {
+		LOG_WRN("%u measurements lost", capture_overflows_get(&m_capture));
+	}
+}
 
 void main(void)
 {
 	#if defined(DPPI_PRESENT)
-    	LOG_INF("Starting Timer + DPPI + GPIOTE Application...");
+		LOG_INF("Starting Timer + DPPI + GPIOTE Application...");
 	#else
 		LOG_INF("Starting Timer + PPI + GPIOTE Application...");
 	#endif
 
-	timer_init();
-	gpiote_init();
-	gppi_init();
+	if (waveform_setup() || capture_setup()) {
+		return;
+	}
 
+	/* Outputs and measurement run without the CPU, it only changes the
+	 * timing and reports the measurements.
+	 */
+	for (size_t i = 1; ; i++) {
+		k_sleep(K_SECONDS(1));
+		capture_log();
+
+		if ((i % 5) == 0) {
+			waveform_update(&m_waveform,
+					&m_timings[(i / 5) % ARRAY_SIZE(m_timings)]);
+		}
+	}
 }
-
-
-
-
@@ -0,0 +1,339 @@
+#include "waveform.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <nrfx_gpiote.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(waveform, LOG_LEVEL_INF);
+
+static uint32_t ns_to_ticks(uint32_t ns)
+{
+	return ((uint64_t)ns * (WAVEFORM_TIMER_HZ / 1000000)) / 1000;
+}
+
+static nrf_timer_cc_channel_t set_cc_channel(size_t idx)
+{
+	return (nrf_timer_cc_channel_t)(2 * idx);
+}
+
+static nrf_timer_cc_channel_t clr_cc_channel(size_t idx)
+{
+	return (nrf_timer_cc_channel_t)(2 * idx + 1);
+}
+
+/* Graph links of an output, SET edge first */
+static uint32_t output_links(size_t idx)
+{
+	return BIT(2 * idx) | BIT(2 * idx + 1);
+}
+
+static int ticks_calc(const struct waveform *wf, const struct waveform_timing *timing,
+		      struct waveform_ticks *ticks)
+{
+	ticks->period = ns_to_ticks(timing->period_ns);
+	if (ticks->period < 2) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < wf->output_count; i++) {
+		uint32_t pulse = ns_to_ticks(timing->out[i].pulse_ns);
+		uint32_t phase = ns_to_ticks(timing->out[i].phase_ns);
+
+		if ((pulse > ticks->period) || (phase >= ticks->period)) {
+			return -EINVAL;
+		}
+
+		if (pulse == 0) {
+			ticks->level[i] = WAVEFORM_LEVEL_LOW;
+			ticks->start_high[i] = false;
+			continue;
+		}
+
+		if (pulse == ticks->period) {
+			ticks->level[i] = WAVEFORM_LEVEL_HIGH;
+			ticks->start_high[i] = true;
+			continue;
+		}
+
+		uint32_t set = phase;
+		uint32_t clr = (phase + pulse) % ticks->period;
+
+		/* COMPARE never fires at 0 as CLEAR does not count, an edge
+		 * at the period start matches together with the period CC.
+		 */
+		ticks->level[i] = WAVEFORM_LEVEL_TOGGLING;
+		ticks->set_cc[i] = set ? set : ticks->period;
+		ticks->clr_cc[i] = clr ? clr : ticks->period;
+		ticks->start_high[i] = (phase == 0) || ((phase + pulse) > ticks->period);
+	}
+
+	return 0;
+}
+
+/* Only called while the timer is stopped */
+static void ticks_apply(struct waveform *wf, const struct waveform_ticks *ticks)
+{
+	for (size_t i = 0; i < wf->output_count; i++) {
+		if (ticks->level[i] == WAVEFORM_LEVEL_TOGGLING) {
+			nrfx_timer_compare(&wf->timer, set_cc_channel(i), ticks->set_cc[i], false);
+			nrfx_timer_compare(&wf->timer, clr_cc_channel(i), ticks->clr_cc[i], false);
+			gppi_graph_links_enable(&wf->graph, output_links(i));
+		} else {
+			gppi_graph_links_disable(&wf->graph, output_links(i));
+		}
+
+		/* Start the new period from a known level */
+		if (ticks->start_high[i]) {
+			nrfx_gpiote_set_task_trigger(wf->pins[i]);
+		} else {
+			nrfx_gpiote_clr_task_trigger(wf->pins[i]);
+		}
+	}
+
+	wf->period = ticks->period;
+	nrfx_timer_extended_compare(&wf->timer, wf->period_cc, ticks->period,
+				    nrf_timer_short_compare_clear_get(wf->period_cc),
+				    false);
+}
+
+/* The STOP shortcut leaves the counter cleared. A compare event from a
+ * period that ended before the shortcut was armed finds it counting, the
+ * period CC borrowed for the capture is restored then.
+ */
+static bool timer_stopped(struct waveform *wf)
+{
+	if (nrfx_timer_capture(&wf->timer, wf->period_cc) == 0) {
+		return true;
+	}
+
+	nrf_timer_cc_set(wf->timer.p_reg, wf->period_cc, wf->period);
+
+	return false;
+}
+
+static void timer_handler(nrf_timer_event_t event_type, void *p_context)
+{
+	struct waveform *wf = p_context;
+
+	if ((event_type != nrf_timer_compare_event_get(wf->period_cc)) ||
+	    !wf->update_pending || !timer_stopped(wf)) {
+		return;
+	}
+
+	ticks_apply(wf, &wf->pending);
+	wf->update_pending = false;
+	nrfx_timer_resume(&wf->timer);
+}
+
+static void output_release(struct waveform *wf, size_t idx)
+{
+	uint32_t pin = wf->pins[idx];
+
+	nrfx_gpiote_clr_task_trigger(pin);
+	nrfx_gpiote_out_task_disable(pin);
+	nrfx_gpiote_pin_uninit(pin);
+	nrfx_gpiote_channel_free(wf->gpiote_ch[idx]);
+}
+
+static int output_init(struct waveform *wf, size_t idx, bool start_high)
+{
+	nrfx_err_t err;
+	uint32_t pin = wf->pins[idx];
+
+	static const nrfx_gpiote_output_config_t output_config = {
+		.drive = NRF_GPIO_PIN_S0S1,
+		.input_connect = NRF_GPIO_PIN_INPUT_DISCONNECT,
+		.pull = NRF_GPIO_PIN_NOPULL,
+	};
+
+	err = nrfx_gpiote_channel_alloc(&wf->gpiote_ch[idx]);
+	if (err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_gpiote_channel_alloc error: 0x%08X", err);
+		return -EBUSY;
+	}
+
+	/* SET and CLR tasks are used, the polarity only enables task mode */
+	const nrfx_gpiote_task_config_t task_config = {
+		.task_ch = wf->gpiote_ch[idx],
+		.polarity = NRF_GPIOTE_POLARITY_TOGGLE,
+		.init_val = start_high,
+	};
+
+	err = nrfx_gpiote_output_configure(pin, &output_config, &task_config);
+	if (err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_gpiote_output_configure error: 0x%08X", err);
+		nrfx_gpiote_channel_free(wf->gpiote_ch[idx]);
+		return -EIO;
+	}
+
+	nrfx_gpiote_out_task_enable(pin);
+
+	return 0;
+}
+
+/* Each output: its SET CC drives the SET task, its CLR CC the CLR task */
+static int graph_setup(struct waveform *wf)
+{
+	struct gppi_graph_link links[2 * WAVEFORM_OUTPUTS_MAX];
+
+	for (size_t i = 0; i < wf->output_count; i++) {
+		links[2 * i] = (struct gppi_graph_link){
+			.eep = nrfx_timer_compare_event_address_get(&wf->timer,
+								    set_cc_channel(i)),
+			.tep = nrfx_gpiote_set_task_addr_get(wf->pins[i]),
+			.group = GPPI_GRAPH_NO_GROUP,
+			.start_disabled = true,
+		};
+		links[2 * i + 1] = (struct gppi_graph_link){
+			.eep = nrfx_timer_compare_event_address_get(&wf->timer,
+								    clr_cc_channel(i)),
+			.tep = nrfx_gpiote_clr_task_addr_get(wf->pins[i]),
+			.group = GPPI_GRAPH_NO_GROUP,
+			.start_disabled = true,
+		};
+	}
+
+	const struct gppi_graph_desc desc = {
+		.links = links,
+		.link_count = 2 * wf->output_count,
+	};
+
+	return gppi_graph_setup(&wf->graph, &desc);
+}
+
+int waveform_init(struct waveform *wf, const struct waveform_config *config)
+{
+	nrfx_err_t nrfx_err;
+	struct waveform_ticks ticks;
+	int err;
+
+	if (!config->output_count ||
+	    (config->output_count > WAVEFORM_OUTPUTS_FOR_CC(config->timer.cc_channel_count))) {
+		LOG_ERR("TIMER%u supports %u outputs", config->timer.instance_id,
+			WAVEFORM_OUTPUTS_FOR_CC(config->timer.cc_channel_count));
+		return -EINVAL;
+	}
+
+	memset(wf, 0, sizeof(*wf));
+	wf->timer = config->timer;
+	wf->output_count = config->output_count;
+	wf->period_cc = (nrf_timer_cc_channel_t)(config->timer.cc_channel_count - 1);
+	memcpy(wf->pins, config->pins, sizeof(wf->pins));
+
+	err = ticks_calc(wf, &config->timing, &ticks);
+	if (err) {
+		LOG_ERR("Invalid waveform timing");
+		return err;
+	}
+
+	nrfx_timer_config_t timer_config = NRFX_TIMER_DEFAULT_CONFIG;
+
+	timer_config.frequency = NRF_TIMER_FREQ_16MHz;
+	timer_config.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	timer_config.p_context = wf;
+	nrfx_err = nrfx_timer_init(&wf->timer, &timer_config, timer_handler);
+	if (nrfx_err != NRFX_SUCCESS) {
+		LOG_ERR("nrfx_timer_init error: %08x", nrfx_err);
+		return -EIO;
+	}
+
+	if (!nrfx_gpiote_is_init()) {
+		/* The priority is ignored, see nrfx_glue.h */
+		nrfx_err = nrfx_gpiote_init(0);
+		if (nrfx_err != NRFX_SUCCESS) {
+			LOG_ERR("nrfx_gpiote_init error: 0x%08X", nrfx_err);
+			nrfx_timer_uninit(&wf->timer);
+			return -EIO;
+		}
+	}
+
+	for (size_t i = 0; i < wf->output_count; i++) {
+		err = output_init(wf, i, ticks.start_high[i]);
+		if (err) {
+			while (i--) {
+				output_release(wf, i);
+			}
+			nrfx_timer_uninit(&wf->timer);
+			return err;
+		}
+	}
+
+	/* Links stay off until the timing enables them */
+	err = graph_setup(wf);
+	if (err) {
+		for (size_t i = 0; i < wf->output_count; i++) {
+			output_release(wf, i);
+		}
+		nrfx_timer_uninit(&wf->timer);
+		return err;
+	}
+
+	ticks_apply(wf, &ticks);
+
+	return 0;
+}
+
+int waveform_start(struct waveform *wf)
+{
+	if (wf->running) {
+		return -EALREADY;
+	}
+
+	nrfx_timer_clear(&wf->timer);
+	nrfx_timer_enable(&wf->timer);
+	wf->running = true;
+
+	return 0;
+}
+
+int waveform_update(struct waveform *wf, const struct waveform_timing *timing)
+{
+	struct waveform_ticks ticks;
+	int err;
+
+	err = ticks_calc(wf, timing, &ticks);
+	if (err) {
+		return err;
+	}
+
+	unsigned int key = irq_lock();
+
+	if (wf->running) {
+		wf->pending = ticks;
+		/* Halt on the next period boundary until the interrupt applied
+		 * it, already armed if an update is pending.
+		 */
+		if (!wf->update_pending) {
+			nrf_timer_event_clear(wf->timer.p_reg,
+					      nrf_timer_compare_event_get(wf->period_cc));
+			nrfx_timer_extended_compare(&wf->timer, wf->period_cc, wf->period,
+						    nrf_timer_short_compare_clear_get(wf->period_cc) |
+						    nrf_timer_short_compare_stop_get(wf->period_cc),
+						    true);
+		}
+		wf->update_pending = true;
+	} else {
+		ticks_apply(wf, &ticks);
+	}
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+void waveform_deinit(struct waveform *wf)
+{
+	nrfx_timer_disable(&wf->timer);
+	wf->running = false;
+	wf->update_pending = false;
+
+	gppi_graph_teardown(&wf->graph);
+
+	for (size_t i = 0; i < wf->output_count; i++) {
+		output_release(wf, i);
+	}
+
+	nrfx_timer_uninit(&wf->timer);
+}
@@ -0,0 +1,100 @@
+#ifndef WAVEFORM_H_
+#define WAVEFORM_H_
+
+#include <zephyr/kernel.h>
+#include <nrfx_timer.h>
+
+#include "gppi_graph.h"
+
+/*
+ * Hardware PWM/waveform generator.
+ *
+ * One TIMER runs with its last CC channel as the period. Every output
+ * takes two more CC channels whose COMPARE events drive the GPIOTE SET
+ * and CLR tasks of its pin over (D)PPI, so an output goes high at its
+ * phase and low pulse_ns later, wrapping around the period. Once started
+ * no CPU is involved.
+ *
+ * The TIMER compare registers are not buffered, so a pending timing
+ * update arms a STOP shortcut on the period event. The counter then halts
+ * at 0 on the next period boundary, the period interrupt writes the new
+ * compare values and starts it again. No edge is missed or forced out of
+ * place however late the interrupt runs, the period holding the update
+ * is only stretched by the interrupt latency.
+ *
+ * The application connects the TIMER interrupt to the nrfx handler.
+ */
+
+/* Counter frequency, 62.5 ns resolution */
+#define WAVEFORM_TIMER_HZ 16000000
+
+#define WAVEFORM_OUTPUTS_MAX 2
+
+/* Outputs supported by a TIMER with cc_count CC channels */
+#define WAVEFORM_OUTPUTS_FOR_CC(cc_count) MIN(WAVEFORM_OUTPUTS_MAX, ((cc_count) - 1) / 2)
+
+struct waveform_output_timing {
+	/* High time, 0 keeps the pin low and the period keeps it high */
+	uint32_t pulse_ns;
+	/* Rising edge offset from the period start */
+	uint32_t phase_ns;
+};
+
+struct waveform_timing {
+	uint32_t period_ns;
+	struct waveform_output_timing out[WAVEFORM_OUTPUTS_MAX];
+};
+
+struct waveform_config {
+	nrfx_timer_t timer;
+	uint32_t pins[WAVEFORM_OUTPUTS_MAX];
+	size_t output_count;
+	struct waveform_timing timing;
+};
+
+enum waveform_level {
+	WAVEFORM_LEVEL_LOW,
+	WAVEFORM_LEVEL_HIGH,
+	WAVEFORM_LEVEL_TOGGLING,
+};
+
+/* Timing converted to TIMER compare values */
+struct waveform_ticks {
+	uint32_t period;
+	uint32_t set_cc[WAVEFORM_OUTPUTS_MAX];
+	uint32_t clr_cc[WAVEFORM_OUTPUTS_MAX];
+	enum waveform_level level[WAVEFORM_OUTPUTS_MAX];
+	/* Pin level at the period start */
+	bool start_high[WAVEFORM_OUTPUTS_MAX];
+};
+
+/* Waveform instance, all fields are private */
+struct waveform {
+	nrfx_timer_t timer;
+	uint32_t pins[WAVEFORM_OUTPUTS_MAX];
+	size_t output_count;
+	uint8_t gpiote_ch[WAVEFORM_OUTPUTS_MAX];
+	struct gppi_graph graph;
+	nrf_timer_cc_channel_t period_cc;
+	/* Period compare value in use */
+	uint32_t period;
+	struct waveform_ticks pending;
+	bool update_pending;
+	bool running;
+};
+
+/* Claim GPIOTE and (D)PPI channels and configure the outputs, not started */
+int waveform_init(struct waveform *wf, const struct waveform_config *config);
+
+/* Start all outputs from the period start */
+int waveform_start(struct waveform *wf);
+
+/* Change the period and output timing at the next period boundary. Only
+ * the latest timing is applied if called more than once per period.
+ */
+int waveform_update(struct waveform *wf, const struct waveform_timing *timing);
+
+/* Stop the outputs, leave the pins low and release all channels */
+void waveform_deinit(struct waveform *wf);
+
+#endif /* WAVEFORM_H_ */
@@ -2,47 +2,75 @@
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/uart.h>
 #include <zephyr/sys/util.h>
 #include <nrfx_rtc.h>
 #include <nrfx_timer.h>
 #include <zephyr/pm/device.h>
+#include <string.h>
+#include <debounce.h>
+#include <uart_autosuspend.h>
 
 static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led1), gpios);
 static const struct gpio_dt_spec button1 = GPIO_DT_SPEC_GET(DT_ALIAS(sw1), gpios);
 
 const struct device *uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
 
-// Referente the UART RX pin on nRF52840DK
-#define RX_DEVICE DT_NODELABEL(gpio0)
-#define RX_PIN 8
-const struct device *gpio_dev;
+/* The UART RX pin, P0.08 on the nRF52840DK */
+static const struct gpio_dt_spec rx_wakeup =
+	GPIO_DT_SPEC_GET(DT_PATH(zephyr_user), uart_wakeup_gpios);
+static struct uart_autosuspend uart_as;
 
+static char cmd_buf[32];
+static size_t cmd_len;
+static char cmd[sizeof(cmd_buf)];
 
-static void uart0_set_enable(bool enable)
+static void cmd_work_fn(struct k_work *work)
 {
-	const struct device *uart_dev = DEVICE_DT_GET(DT_NODELABEL(uart0));
+	struct uart_autosuspend_stats stats;
+
+	uart_autosuspend_stats_get(&uart_as, &stats);
+	printk("Command: %s\n", cmd);
+	printk("%u suspends, %u wakeups (%u late), resume %u us (max %u us), "
+	       "%u preamble bytes, %u%% suspended\n",
+	       stats.suspends, stats.wakeups, stats.late_wakeups, stats.resume_latency_us,
+	       stats.resume_latency_max_us, stats.preamble_bytes, stats.idle_percent);
+}
+static K_WORK_DEFINE(cmd_work, cmd_work_fn);
+
+static void uart_isr(const struct device *dev, void *user_data)
+{
+	uint8_t c;
 
-	if (!device_is_ready(uart_dev)) {
+	if (!uart_irq_update(dev) || !uart_irq_rx_ready(dev)) {
 		return;
 	}
 
-	gpio_pin_interrupt_configure(gpio_dev, RX_PIN, enable? GPIO_INT_DISABLE : GPIO_INT_EDGE_TO_ACTIVE);
-	gpio_pin_set_dt(&led, enable ? 1 : 0);
-	pm_device_action_run(uart_dev, enable ? PM_DEVICE_ACTION_RESUME : PM_DEVICE_ACTION_SUSPEND);
-}
-
-/* Button handler functions */
-static void rx_handler(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
-{
-    uart0_set_enable(true);
+	while (uart_fifo_read(dev, &c, 1) == 1) {
+		if (uart_autosuspend_rx_filter(&uart_as, c)) {
+			continue;
+		}
+
+		if ((c == '\r') || (c == '\n')) {
+			if (cmd_len) {
+				cmd_buf[cmd_len] = '\0';
+				memcpy(cmd, cmd_buf, cmd_len + 1);
+				cmd_len = 0;
+				k_work_submit(&cmd_work);
+			}
+		} else if (cmd_len < (sizeof(cmd_buf) - 1)) {
+			cmd_buf[cmd_len++] = c;
+		}
+	}
 }
-static struct gpio_callback rx_cb;
 
-static void button1_handler(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+static void button1_handler(struct debounce_input *input, const struct debounce_event *evt)
 {
-    uart0_set_enable(false);
+    if (evt->type == DEBOUNCE_PRESSED) {
+        uart_autosuspend_suspend(&uart_as);
+    }
 }
-static struct gpio_callback button1_cb;
+static struct debounce_input button1_input;
 
 void main(void)
 {
@@ -55,19 +83,18 @@ void main(void)
 	gpio_add_callback(button0.port, &button0_cb);
 	*/
 
-	gpio_pin_configure_dt(&button1, GPIO_INPUT);
-	gpio_pin_interrupt_configure_dt(&button1, GPIO_INT_EDGE_TO_ACTIVE);
-	gpio_init_callback(&button1_cb, button1_handler, BIT(button1.pin));
-	gpio_add_callback(button1.port, &button1_cb);
-
+	debounce_input_init(&button1_input, &button1, button1_handler);
 
-	gpio_dev = DEVICE_DT_GET(RX_DEVICE);
-	//gpio_pin_configure(gpio_dev, RX_PIN, GPIO_INPUT | GPIO_PULL_UP);
-	gpio_pin_interrupt_configure(gpio_dev, RX_PIN, GPIO_INT_EDGE_TO_ACTIVE);
-	gpio_init_callback(&rx_cb, rx_handler, BIT(RX_PIN));
-	gpio_add_callback(gpio_dev, &rx_cb);
+	/* Send a few 0xff before a command, the first byte after a suspend
+	 * only resumes the UART
+	 */
+	if (uart_autosuspend_init(&uart_as, uart_dev, &rx_wakeup)) {
+		printk("UART autosuspend setup failed\n");
+		return;
+	}
 
-	uart0_set_enable(true);
+	uart_irq_callback_set(uart_dev, uart_isr);
+	uart_irq_rx_enable(uart_dev);
 
 	if (!device_is_ready(led.port)) {
 		return;
@@ -78,7 +105,12 @@ void main(void)
 	}
 
 	while (1) {
-		printk("Printing...\n");
+		bool suspended = uart_autosuspend_is_suspended(&uart_as);
+
+		gpio_pin_set_dt(&led, suspended ? 0 : 1);
+		if (!suspended) {
+			printk("Printing...\n");
+		}
 		k_sleep(K_SECONDS(1));
 	}
 